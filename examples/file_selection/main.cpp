@@ -18,8 +18,9 @@ class MyNode : public Node {
             panel->set_theme_panel(new_theme);
         }
 
-        DefaultResource::get_singleton()->set_default_font(
-                std::make_shared<Font>("assets/fonts/unifont-16.0.02.otf"));
+        if (auto font = TextServer::get_singleton()->load_font_from_file("assets/fonts/unifont-16.0.02.otf")) {
+            DefaultResource::get_singleton()->set_default_font(font);
+        }
 
         auto margin_container = std::make_shared<MarginContainer>();
         margin_container->set_margin_all(8);
@@ -50,13 +51,12 @@ class MyNode : public Node {
 
         std::weak_ptr file_dialog_weak = file_dialog;
         std::weak_ptr text_edit_weak = text_edit;
-        auto callback = [file_dialog_weak, text_edit_weak] {
+        select_button->pressed_signal.connect([file_dialog_weak, text_edit_weak] {
             auto path = file_dialog_weak.lock()->show();
             if (path.has_value()) {
                 text_edit_weak.lock()->set_text(path.value());
             }
-        };
-        select_button->connect_signal("pressed", callback);
+        });
         hbox_container->add_child(select_button);
 
         auto confirm_button = std::make_shared<Button>();
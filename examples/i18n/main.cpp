@@ -36,8 +36,10 @@ class MyNode : public Node {
         text += "שלום עולם!\n\n";                // Hebrew
         text += "Hello123!مرحبا٠١٢!你好123！\n"; // Mixed languages
 
-        // auto font = std::make_shared<Font>("assets/fonts/test.ttf");
-        DefaultResource::get_singleton()->set_default_font(std::make_shared<Font>("assets/fonts/unifont-16.0.02.otf"));
+        // auto font = TextServer::get_singleton()->load_font_from_file("assets/fonts/test.ttf");
+        if (auto font = TextServer::get_singleton()->load_font_from_file("assets/fonts/unifont-16.0.02.otf")) {
+            DefaultResource::get_singleton()->set_default_font(font);
+        }
 
         // No word wrapping.
         {
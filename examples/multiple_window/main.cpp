@@ -25,11 +25,9 @@ class MyNode : public Node {
         label->set_text("This is a sub-window.");
         sub_window->add_child(label);
 
-        auto callback1 = [sub_window] { sub_window->set_visibility(true); };
-        open_window_button->connect_signal("pressed", callback1);
+        open_window_button->pressed_signal.connect([sub_window] { sub_window->set_visibility(true); });
 
-        auto callback2 = [sub_window] { sub_window->set_visibility(false); };
-        close_window_button->connect_signal("pressed", callback2);
+        close_window_button->pressed_signal.connect([sub_window] { sub_window->set_visibility(false); });
     }
 };
 
@@ -15,9 +15,11 @@ class MyNode : public Node {
         collapse->set_size({400, 300});
         add_child(collapse);
 
+        auto scroll_container = std::make_shared<ScrollContainer>();
+        collapse->add_child(scroll_container);
+
         auto tree = std::make_shared<Tree>();
-        tree->set_anchor_flag(AnchorFlag::FullRect);
-        collapse->add_child(tree);
+        scroll_container->add_child(tree);
 
         // Set up tree items.
         {
@@ -35,6 +37,13 @@ class MyNode : public Node {
             child_node_2d->set_icon(resource_mgr->load<VectorImage>("assets/icons/Node_Node2D.svg"));
             auto child_node_3d = tree->create_item(tree_root, "Node3d");
             child_node_3d->set_icon(resource_mgr->load<VectorImage>("assets/icons/Node_Node3D.svg"));
+
+            // Only visible rows get widgets, so large trees are fine.
+            auto many_items = tree->create_item(tree_root, "Many items");
+            for (int i = 0; i < 100000; i++) {
+                tree->create_item(many_items, "Item " + std::to_string(i));
+            }
+            many_items->set_collapsed(true);
         }
     }
 };
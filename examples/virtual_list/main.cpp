@@ -0,0 +1,46 @@
+#include "app.h"
+
+using namespace revector;
+
+using Pathfinder::Vec2;
+using Pathfinder::Vec3;
+
+class MyNode : public Node {
+    void custom_ready() override {
+        auto panel = std::make_shared<Panel>();
+        panel->set_position({100, 100});
+        panel->set_size({300, 400});
+        add_child(panel);
+
+        auto scroll_container = std::make_shared<ScrollContainer>();
+        scroll_container->set_anchor_flag(AnchorFlag::FullRect);
+        panel->add_child(scroll_container);
+
+        auto list = std::make_shared<VirtualListContainer>();
+        list->set_separation(4);
+        list->set_row_height(32);
+        scroll_container->add_child(list);
+
+        // Only the visible buttons are created, the rest are recycled when scrolling.
+        list->set_row_builder([](uint32_t item_index, std::shared_ptr<NodeUi> recycled_row) {
+            auto button = std::dynamic_pointer_cast<Button>(recycled_row);
+            if (button == nullptr) {
+                button = make_node<Button>();
+            }
+            button->set_text("Item " + std::to_string(item_index));
+            return std::static_pointer_cast<NodeUi>(button);
+        });
+
+        list->set_item_count(1000000);
+    }
+};
+
+int main() {
+    App app({640, 480});
+
+    app.get_tree()->replace_root(std::make_shared<MyNode>());
+
+    app.main_loop();
+
+    return EXIT_SUCCESS;
+}
@@ -96,6 +96,7 @@ void App::main_loop() {
     while (!get_primary_window()->should_close()) {
         InputServer::get_singleton()->clear_events();
         RenderServer::get_singleton()->window_builder_->poll_events();
+        InputServer::get_singleton()->coalesce_events();
 
         auto primary_window = get_primary_window();
 
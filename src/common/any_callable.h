@@ -6,6 +6,8 @@
 #include <map>
 #include <string>
 
+#include "utils.h"
+
 namespace revector {
 
 template <typename Ret>
@@ -24,4 +26,17 @@ struct AnyCallable {
     std::any m_any;
 };
 
+/// Adapt an AnyCallable to a typed signal slot.
+/// Mismatched argument types are reported at emission instead of being thrown.
+template <typename... Args>
+auto make_typed_slot(const AnyCallable<void>& callback) {
+    return [callback = callback](Args... args) mutable {
+        try {
+            callback.template operator()<Args...>(std::move(args)...);
+        } catch (std::bad_any_cast&) {
+            Logger::error("Mismatched signal argument types!", "revector");
+        }
+    };
 }
+
+} // namespace revector
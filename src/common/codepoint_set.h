@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace revector {
+
+/// A set of Unicode codepoints as a two-level bitmap: blocks of 256 codepoints, where empty blocks take no space.
+/// Lookups are O(1).
+class CodepointSet {
+public:
+    static constexpr uint32_t CODEPOINT_COUNT = 0x110000;
+
+    static constexpr uint32_t BLOCK_SIZE = 256;
+
+    void insert(uint32_t codepoint) {
+        if (codepoint >= CODEPOINT_COUNT) {
+            return;
+        }
+
+        if (block_indices.empty()) {
+            block_indices.assign(CODEPOINT_COUNT / BLOCK_SIZE, 0);
+            // Block 0 is the shared empty block.
+            blocks.emplace_back();
+        }
+
+        auto &block_index = block_indices[codepoint / BLOCK_SIZE];
+        if (block_index == 0) {
+            block_index = blocks.size();
+            blocks.emplace_back();
+        }
+
+        auto offset = codepoint % BLOCK_SIZE;
+        blocks[block_index][offset / 64] |= uint64_t(1) << (offset % 64);
+    }
+
+    bool contains(uint32_t codepoint) const {
+        if (codepoint >= CODEPOINT_COUNT || block_indices.empty()) {
+            return false;
+        }
+
+        auto offset = codepoint % BLOCK_SIZE;
+        return (blocks[block_indices[codepoint / BLOCK_SIZE]][offset / 64] >> (offset % 64)) & 1;
+    }
+
+private:
+    using Block = std::array<uint64_t, BLOCK_SIZE / 64>;
+
+    std::vector<uint16_t> block_indices;
+
+    std::vector<Block> blocks;
+};
+
+} // namespace revector
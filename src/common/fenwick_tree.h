@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace revector {
+
+/// Binary indexed tree for prefix sums with logarithmic updates and lookups.
+/// Used to map between item indices and accumulated sizes (rows, heights) in virtualized widgets.
+template <typename T>
+class FenwickTree {
+public:
+    /// Replace all values with `count` copies of `value`, in O(n).
+    void assign(size_t count, T value) {
+        nodes_.assign(count + 1, T{});
+        for (size_t i = 1; i <= count; i++) {
+            nodes_[i] += value;
+            size_t parent = i + lowbit(i);
+            if (parent <= count) {
+                nodes_[parent] += nodes_[i];
+            }
+        }
+    }
+
+    void push_back(T value) {
+        if (nodes_.empty()) {
+            nodes_.push_back(T{});
+        }
+
+        size_t i = nodes_.size();
+        nodes_.push_back(value + prefix_sum(i - 1) - prefix_sum(i - lowbit(i)));
+    }
+
+    void add(size_t index, T delta) {
+        for (size_t i = index + 1; i < nodes_.size(); i += lowbit(i)) {
+            nodes_[i] += delta;
+        }
+    }
+
+    /// Sum of the first `count` values.
+    T prefix_sum(size_t count) const {
+        T sum{};
+        for (size_t i = count; i > 0; i -= lowbit(i)) {
+            sum += nodes_[i];
+        }
+        return sum;
+    }
+
+    /// Find the value whose accumulated range contains `offset`.
+    /// On return, `offset` is relative to the start of that value. Returns size() if out of range.
+    size_t find(T &offset) const {
+        size_t n = size();
+
+        size_t step = 1;
+        while (step * 2 <= n) {
+            step *= 2;
+        }
+
+        // Find the last position whose prefix sum is not greater than the offset.
+        size_t position = 0;
+        for (; n > 0 && step > 0; step /= 2) {
+            if (position + step <= n && !(offset < nodes_[position + step])) {
+                position += step;
+                offset -= nodes_[position];
+            }
+        }
+
+        return position;
+    }
+
+    size_t size() const {
+        return nodes_.empty() ? 0 : nodes_.size() - 1;
+    }
+
+    void clear() {
+        nodes_.clear();
+    }
+
+private:
+    static size_t lowbit(size_t i) {
+        return i & (~i + 1);
+    }
+
+    // Index 0 is unused.
+    std::vector<T> nodes_;
+};
+
+} // namespace revector
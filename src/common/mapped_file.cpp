@@ -0,0 +1,102 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace revector {
+
+#ifdef _WIN32
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string &path) {
+    HANDLE file = CreateFileA(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    std::shared_ptr<MappedFile> mapped_file(new MappedFile());
+    mapped_file->data_ = static_cast<const char *>(view);
+    mapped_file->size_ = file_size.QuadPart;
+    mapped_file->file_handle = file;
+    mapped_file->mapping_handle = mapping;
+
+    return mapped_file;
+}
+
+MappedFile::~MappedFile() {
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_handle);
+    CloseHandle(file_handle);
+}
+
+#else
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    void *view = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+
+    if (view == MAP_FAILED) {
+        return nullptr;
+    }
+
+    std::shared_ptr<MappedFile> mapped_file(new MappedFile());
+    mapped_file->data_ = static_cast<const char *>(view);
+    mapped_file->size_ = file_stat.st_size;
+
+    return mapped_file;
+}
+
+MappedFile::~MappedFile() {
+    munmap(const_cast<char *>(data_), size_);
+}
+
+#endif
+
+const char *MappedFile::data() const {
+    return data_;
+}
+
+size_t MappedFile::size() const {
+    return size_;
+}
+
+} // namespace revector
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace revector {
+
+/// A read-only file mapped into memory. Pages are loaded by the OS on access and shared between processes.
+class MappedFile {
+public:
+    /// Returns null if the file can't be opened or is empty.
+    static std::shared_ptr<MappedFile> open(const std::string &path);
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile();
+
+    const char *data() const;
+
+    size_t size() const;
+
+private:
+    MappedFile() = default;
+
+    const char *data_{};
+
+    size_t size_ = 0;
+
+#ifdef _WIN32
+    void *file_handle{};
+    void *mapping_handle{};
+#endif
+};
+
+} // namespace revector
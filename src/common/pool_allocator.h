@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace revector {
+
+/// A free list of fixed-size blocks, which are allocated from the heap in growing chunks.
+/// Not thread safe, nodes are created and destroyed on the main thread.
+template <size_t BlockSize, size_t BlockAlign>
+class FixedBlockPool {
+public:
+    static FixedBlockPool *get_singleton() {
+        // Intentionally leaked, so that nodes destroyed during static destruction can still be returned to the pool.
+        static auto singleton = new FixedBlockPool;
+        return singleton;
+    }
+
+    void *allocate() {
+        if (free_list_ == nullptr) {
+            grow();
+        }
+
+        auto block = free_list_;
+        free_list_ = block->next;
+
+        return block;
+    }
+
+    void deallocate(void *ptr) {
+        auto block = static_cast<Block *>(ptr);
+        block->next = free_list_;
+        free_list_ = block;
+    }
+
+private:
+    union Block {
+        Block *next;
+        alignas(BlockAlign) unsigned char data[BlockSize];
+    };
+
+    static constexpr size_t MIN_CHUNK_BLOCK_COUNT = 64;
+    static constexpr size_t MAX_CHUNK_BLOCK_COUNT = 4096;
+
+    void grow() {
+        size_t block_count = std::min(MIN_CHUNK_BLOCK_COUNT << std::min(chunks_.size(), (size_t)6),
+                                      MAX_CHUNK_BLOCK_COUNT);
+
+        auto chunk = std::make_unique<Block[]>(block_count);
+
+        for (size_t i = 0; i < block_count; i++) {
+            chunk[i].next = i + 1 < block_count ? &chunk[i + 1] : free_list_;
+        }
+        free_list_ = &chunk[0];
+
+        chunks_.push_back(std::move(chunk));
+    }
+
+    std::vector<std::unique_ptr<Block[]>> chunks_;
+
+    Block *free_list_{};
+};
+
+/// Standard allocator backed by FixedBlockPool. Types of similar sizes share the same pool.
+template <typename T>
+struct PoolAllocator {
+    using value_type = T;
+
+    PoolAllocator() = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &) {
+    }
+
+    T *allocate(size_t n) {
+        if constexpr (use_pool()) {
+            if (n == 1) {
+                return static_cast<T *>(get_pool()->allocate());
+            }
+        }
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, size_t n) {
+        if constexpr (use_pool()) {
+            if (n == 1) {
+                get_pool()->deallocate(ptr);
+                return;
+            }
+        }
+        ::operator delete(ptr);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U> &) const {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U> &) const {
+        return false;
+    }
+
+private:
+    static constexpr size_t BLOCK_GRANULARITY = 16;
+
+    static constexpr bool use_pool() {
+        return alignof(T) <= alignof(std::max_align_t);
+    }
+
+    static auto get_pool() {
+        constexpr size_t block_size = (sizeof(T) + BLOCK_GRANULARITY - 1) / BLOCK_GRANULARITY * BLOCK_GRANULARITY;
+        return FixedBlockPool<block_size, alignof(std::max_align_t)>::get_singleton();
+    }
+};
+
+} // namespace revector
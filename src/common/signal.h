@@ -0,0 +1,339 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace revector {
+
+/// Move-only callable with small buffer optimization.
+/// Functors no larger than InlineSize (e.g. lambdas capturing `this` and a few values) are stored inline,
+/// so connecting and invoking them doesn't touch the heap. Larger functors fall back to a heap allocation.
+template <typename Sig, size_t InlineSize = 4 * sizeof(void *)>
+class Callable;
+
+template <typename R, typename... Args, size_t InlineSize>
+class Callable<R(Args...), InlineSize> {
+public:
+    Callable() = default;
+
+    template <typename F,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Callable> &&
+                                          std::is_invocable_r_v<R, std::decay_t<F> &, Args...>>>
+    Callable(F &&f) {
+        using Functor = std::decay_t<F>;
+
+        if constexpr (fits_inline<Functor>()) {
+            new (&storage_) Functor(std::forward<F>(f));
+        } else {
+            *reinterpret_cast<Functor **>(&storage_) = new Functor(std::forward<F>(f));
+        }
+        ops_ = &ops_for<Functor>;
+    }
+
+    Callable(Callable &&other) noexcept {
+        move_from(other);
+    }
+
+    Callable &operator=(Callable &&other) noexcept {
+        if (this != &other) {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    Callable(const Callable &) = delete;
+
+    Callable &operator=(const Callable &) = delete;
+
+    ~Callable() {
+        reset();
+    }
+
+    R operator()(Args... args) {
+        return ops_->invoke(&storage_, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const {
+        return ops_ != nullptr;
+    }
+
+    void reset() {
+        if (ops_) {
+            ops_->destroy(&storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        R (*invoke)(void *storage, Args &&...args);
+        void (*move)(void *src, void *dst);
+        void (*destroy)(void *storage);
+    };
+
+    template <typename Functor>
+    static constexpr bool fits_inline() {
+        return sizeof(Functor) <= InlineSize && alignof(Functor) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<Functor>;
+    }
+
+    template <typename Functor>
+    static Functor *get(void *storage) {
+        if constexpr (fits_inline<Functor>()) {
+            return std::launder(reinterpret_cast<Functor *>(storage));
+        } else {
+            return *reinterpret_cast<Functor **>(storage);
+        }
+    }
+
+    template <typename Functor>
+    static constexpr Ops ops_for = {
+        [](void *storage, Args &&...args) -> R { return (*get<Functor>(storage))(std::forward<Args>(args)...); },
+        [](void *src, void *dst) {
+            if constexpr (fits_inline<Functor>()) {
+                new (dst) Functor(std::move(*get<Functor>(src)));
+                get<Functor>(src)->~Functor();
+            } else {
+                // Just steal the heap pointer.
+                *reinterpret_cast<Functor **>(dst) = get<Functor>(src);
+            }
+        },
+        [](void *storage) {
+            if constexpr (fits_inline<Functor>()) {
+                get<Functor>(storage)->~Functor();
+            } else {
+                delete get<Functor>(storage);
+            }
+        },
+    };
+
+    void move_from(Callable &other) {
+        if (other.ops_) {
+            other.ops_->move(&other.storage_, &storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    std::aligned_storage_t<InlineSize, alignof(std::max_align_t)> storage_;
+
+    const Ops *ops_ = nullptr;
+};
+
+/// Handle returned by TypedSignal::connect(), used to disconnect a slot later.
+struct SignalConnection {
+    uint32_t id = 0;
+
+    bool is_valid() const {
+        return id != 0;
+    }
+};
+
+class DeferredSignal;
+
+/// Collects signals with deferred emissions and dispatches them in one batch per frame.
+class SignalQueue {
+public:
+    static SignalQueue *get_singleton() {
+        static SignalQueue singleton;
+        return &singleton;
+    }
+
+    void enqueue(DeferredSignal *signal) {
+        queued_signals_.push_back(signal);
+    }
+
+    void dequeue(DeferredSignal *signal) {
+        queued_signals_.erase(std::remove(queued_signals_.begin(), queued_signals_.end(), signal),
+                              queued_signals_.end());
+
+        // The signal may be destroyed by a slot during flushing.
+        std::replace(flushing_signals_.begin(), flushing_signals_.end(), signal, (DeferredSignal *)nullptr);
+    }
+
+    /// Dispatch all pending emissions. Emissions deferred by the slots themselves are dispatched in the next flush.
+    inline void flush();
+
+private:
+    std::vector<DeferredSignal *> queued_signals_;
+    std::vector<DeferredSignal *> flushing_signals_;
+};
+
+/// Type-independent part of TypedSignal, needed by SignalQueue.
+class DeferredSignal {
+    friend class SignalQueue;
+
+public:
+    virtual ~DeferredSignal() {
+        if (queued_) {
+            SignalQueue::get_singleton()->dequeue(this);
+        }
+    }
+
+protected:
+    virtual void flush_deferred() = 0;
+
+    void mark_queued() {
+        if (!queued_) {
+            queued_ = true;
+            SignalQueue::get_singleton()->enqueue(this);
+        }
+    }
+
+    bool queued_ = false;
+};
+
+void SignalQueue::flush() {
+    flushing_signals_ = std::move(queued_signals_);
+    queued_signals_.clear();
+
+    for (size_t i = 0; i < flushing_signals_.size(); i++) {
+        auto signal = flushing_signals_[i];
+        if (signal == nullptr) {
+            continue;
+        }
+
+        signal->queued_ = false;
+        signal->flush_deferred();
+    }
+
+    flushing_signals_.clear();
+}
+
+/// A typed signal with any number of connected slots.
+/// Emission is a direct call of each slot, no type erasure lookup or string comparison involved.
+template <typename... Args>
+class TypedSignal final : public DeferredSignal {
+public:
+    using Slot = Callable<void(Args...)>;
+
+    TypedSignal() = default;
+
+    TypedSignal(const TypedSignal &) = delete;
+
+    TypedSignal &operator=(const TypedSignal &) = delete;
+
+    SignalConnection connect(Slot slot) {
+        SignalConnection connection{next_id_++};
+
+        // Don't invalidate the slot being called.
+        if (emitting_) {
+            pending_connections_.push_back({connection.id, std::move(slot)});
+        } else {
+            connections_.push_back({connection.id, std::move(slot)});
+        }
+
+        return connection;
+    }
+
+    void disconnect(SignalConnection connection) {
+        if (!connection.is_valid()) {
+            return;
+        }
+
+        for (auto &c : connections_) {
+            if (c.id == connection.id) {
+                c.id = 0;
+                break;
+            }
+        }
+
+        pending_connections_.erase(
+            std::remove_if(pending_connections_.begin(),
+                           pending_connections_.end(),
+                           [connection](const Connection &c) { return c.id == connection.id; }),
+            pending_connections_.end());
+
+        if (!emitting_) {
+            remove_disconnected();
+        }
+    }
+
+    void disconnect_all() {
+        for (auto &c : connections_) {
+            c.id = 0;
+        }
+        pending_connections_.clear();
+
+        if (!emitting_) {
+            connections_.clear();
+        }
+    }
+
+    size_t get_connection_count() const {
+        size_t count = pending_connections_.size();
+        for (auto &c : connections_) {
+            count += c.id != 0;
+        }
+        return count;
+    }
+
+    void emit(Args... args) {
+        bool nested = emitting_;
+        emitting_ = true;
+
+        // Slots connected during this emission will not be called until the next one.
+        size_t count = connections_.size();
+        for (size_t i = 0; i < count; i++) {
+            if (connections_[i].id != 0) {
+                connections_[i].slot(args...);
+            }
+        }
+
+        if (!nested) {
+            emitting_ = false;
+            remove_disconnected();
+
+            for (auto &c : pending_connections_) {
+                connections_.push_back(std::move(c));
+            }
+            pending_connections_.clear();
+        }
+    }
+
+    /// Queue an emission, which will be dispatched with all other deferred emissions by SignalQueue::flush().
+    void emit_deferred(Args... args) {
+        pending_emissions_.emplace_back(std::move(args)...);
+        mark_queued();
+    }
+
+private:
+    struct Connection {
+        uint32_t id;
+        Slot slot;
+    };
+
+    void flush_deferred() override {
+        auto emissions = std::move(pending_emissions_);
+        pending_emissions_.clear();
+
+        for (auto &args : emissions) {
+            std::apply([this](auto &...a) { emit(a...); }, args);
+        }
+    }
+
+    void remove_disconnected() {
+        connections_.erase(std::remove_if(connections_.begin(),
+                                          connections_.end(),
+                                          [](const Connection &c) { return c.id == 0; }),
+                           connections_.end());
+    }
+
+    std::vector<Connection> connections_;
+    std::vector<Connection> pending_connections_;
+
+    std::vector<std::tuple<Args...>> pending_emissions_;
+
+    uint32_t next_id_ = 1;
+
+    bool emitting_ = false;
+};
+
+} // namespace revector
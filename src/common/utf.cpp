@@ -0,0 +1,433 @@
+#include "utf.h"
+
+#ifdef __ANDROID__
+    #include <sse2neon.h>
+#else
+    #include <emmintrin.h>
+#endif
+
+#include <bitset>
+#include <cstdint>
+
+namespace revector {
+
+namespace {
+
+/// What to do with invalid input.
+enum class Mode {
+    /// Stop at the first invalid sequence.
+    Validate,
+    /// Write U+FFFD for each invalid sequence.
+    Replace,
+    /// Assume valid input.
+    Trust,
+};
+
+bool is_surrogate(char32_t codepoint) {
+    return codepoint >= 0xD800 && codepoint <= 0xDFFF;
+}
+
+bool is_valid_codepoint(char32_t codepoint) {
+    return codepoint <= 0x10FFFF && !is_surrogate(codepoint);
+}
+
+/// Whether the 16 bytes at `src` are all ASCII.
+bool is_ascii_block(const char *src) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+    return _mm_movemask_epi8(v) == 0;
+}
+
+/// Decode the sequence at `src[i]`, advancing `i`. Returns false and leaves `i` if it's invalid.
+template <Mode mode>
+bool decode_utf8(const unsigned char *src, size_t size, size_t &i, char32_t &codepoint) {
+    unsigned char lead = src[i];
+
+    if (lead < 0x80) {
+        codepoint = lead;
+        i++;
+        return true;
+    }
+
+    size_t continuation_count;
+    char32_t min_codepoint;
+    if ((lead & 0xE0) == 0xC0) {
+        continuation_count = 1;
+        codepoint = lead & 0x1F;
+        min_codepoint = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        continuation_count = 2;
+        codepoint = lead & 0x0F;
+        min_codepoint = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        continuation_count = 3;
+        codepoint = lead & 0x07;
+        min_codepoint = 0x10000;
+    } else {
+        return false;
+    }
+
+    if constexpr (mode == Mode::Trust) {
+        for (size_t k = 1; k <= continuation_count; k++) {
+            codepoint = codepoint << 6 | (src[i + k] & 0x3F);
+        }
+    } else {
+        if (continuation_count >= size - i) {
+            return false;
+        }
+        for (size_t k = 1; k <= continuation_count; k++) {
+            auto byte = src[i + k];
+            if ((byte & 0xC0) != 0x80) {
+                return false;
+            }
+            codepoint = codepoint << 6 | (byte & 0x3F);
+        }
+        // Overlong forms, surrogates and out of range.
+        if (codepoint < min_codepoint || !is_valid_codepoint(codepoint)) {
+            return false;
+        }
+    }
+
+    i += continuation_count + 1;
+    return true;
+}
+
+size_t encode_utf8(char32_t codepoint, char *dst) {
+    if (codepoint < 0x80) {
+        dst[0] = (char)codepoint;
+        return 1;
+    }
+    if (codepoint < 0x800) {
+        dst[0] = (char)(0xC0 | codepoint >> 6);
+        dst[1] = (char)(0x80 | (codepoint & 0x3F));
+        return 2;
+    }
+    if (codepoint < 0x10000) {
+        dst[0] = (char)(0xE0 | codepoint >> 12);
+        dst[1] = (char)(0x80 | (codepoint >> 6 & 0x3F));
+        dst[2] = (char)(0x80 | (codepoint & 0x3F));
+        return 3;
+    }
+    dst[0] = (char)(0xF0 | codepoint >> 18);
+    dst[1] = (char)(0x80 | (codepoint >> 12 & 0x3F));
+    dst[2] = (char)(0x80 | (codepoint >> 6 & 0x3F));
+    dst[3] = (char)(0x80 | (codepoint & 0x3F));
+    return 4;
+}
+
+size_t utf8_length(char32_t codepoint) {
+    if (codepoint < 0x80) {
+        return 1;
+    }
+    if (codepoint < 0x800) {
+        return 2;
+    }
+    if (codepoint < 0x10000 || !is_valid_codepoint(codepoint)) {
+        // Including U+FFFD.
+        return 3;
+    }
+    return 4;
+}
+
+size_t encode_utf16(char32_t codepoint, char16_t *dst) {
+    if (codepoint < 0x10000) {
+        dst[0] = (char16_t)codepoint;
+        return 1;
+    }
+    codepoint -= 0x10000;
+    dst[0] = (char16_t)(0xD800 | codepoint >> 10);
+    dst[1] = (char16_t)(0xDC00 | (codepoint & 0x3FF));
+    return 2;
+}
+
+template <Mode mode, typename T>
+UtfResult utf8_to(const char *src, size_t size, T *dst) {
+    auto bytes = reinterpret_cast<const unsigned char *>(src);
+
+    UtfResult result;
+    size_t i = 0;
+
+    while (i < size) {
+        // Widen 16 ASCII bytes at a time.
+        if (bytes[i] < 0x80 && size - i >= 16 && is_ascii_block(src + i)) {
+            auto zero = _mm_setzero_si128();
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            auto lo = _mm_unpacklo_epi8(v, zero);
+            auto hi = _mm_unpackhi_epi8(v, zero);
+
+            auto out = reinterpret_cast<__m128i *>(dst + result.written);
+            if constexpr (sizeof(T) == 2) {
+                _mm_storeu_si128(out, lo);
+                _mm_storeu_si128(out + 1, hi);
+            } else {
+                _mm_storeu_si128(out, _mm_unpacklo_epi16(lo, zero));
+                _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, zero));
+                _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, zero));
+                _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, zero));
+            }
+
+            i += 16;
+            result.written += 16;
+            continue;
+        }
+
+        char32_t codepoint;
+        if (!decode_utf8<mode>(bytes, size, i, codepoint)) {
+            if (result.error == UTF_VALID) {
+                result.error = i;
+            }
+            if constexpr (mode == Mode::Validate) {
+                return result;
+            }
+            // Skip the lead byte and the continuation bytes following it.
+            i++;
+            while (i < size && (bytes[i] & 0xC0) == 0x80) {
+                i++;
+            }
+            codepoint = UTF_REPLACEMENT_CHARACTER;
+        }
+
+        if constexpr (sizeof(T) == 2) {
+            result.written += encode_utf16(codepoint, dst + result.written);
+        } else {
+            dst[result.written++] = codepoint;
+        }
+    }
+
+    return result;
+}
+
+template <Mode mode>
+UtfResult utf32_to_utf8(const char32_t *src, size_t size, char *dst) {
+    UtfResult result;
+    size_t i = 0;
+
+    while (i < size) {
+        // Narrow 16 ASCII codepoints at a time.
+        if (src[i] < 0x80 && size - i >= 16) {
+            auto in = reinterpret_cast<const __m128i *>(src + i);
+            auto a = _mm_loadu_si128(in);
+            auto b = _mm_loadu_si128(in + 1);
+            auto c = _mm_loadu_si128(in + 2);
+            auto d = _mm_loadu_si128(in + 3);
+
+            auto non_ascii_bits = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)),
+                                                _mm_set1_epi32((int)0xFFFFFF80));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(non_ascii_bits, _mm_setzero_si128())) == 0xFFFF) {
+                auto ab = _mm_packs_epi32(a, b);
+                auto cd = _mm_packs_epi32(c, d);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + result.written), _mm_packus_epi16(ab, cd));
+
+                i += 16;
+                result.written += 16;
+                continue;
+            }
+        }
+
+        auto codepoint = src[i];
+        if constexpr (mode != Mode::Trust) {
+            if (!is_valid_codepoint(codepoint)) {
+                if constexpr (mode == Mode::Validate) {
+                    result.error = i;
+                    return result;
+                }
+                if (result.error == UTF_VALID) {
+                    result.error = i;
+                }
+                codepoint = UTF_REPLACEMENT_CHARACTER;
+            }
+        }
+
+        result.written += encode_utf8(codepoint, dst + result.written);
+        i++;
+    }
+
+    return result;
+}
+
+template <Mode mode>
+UtfResult utf16_to_utf8(const char16_t *src, size_t size, char *dst) {
+    UtfResult result;
+    size_t i = 0;
+
+    while (i < size) {
+        // Narrow 16 ASCII code units at a time.
+        if (src[i] < 0x80 && size - i >= 16) {
+            auto in = reinterpret_cast<const __m128i *>(src + i);
+            auto a = _mm_loadu_si128(in);
+            auto b = _mm_loadu_si128(in + 1);
+
+            auto non_ascii_bits = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16((short)0xFF80));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(non_ascii_bits, _mm_setzero_si128())) == 0xFFFF) {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + result.written), _mm_packus_epi16(a, b));
+
+                i += 16;
+                result.written += 16;
+                continue;
+            }
+        }
+
+        char32_t codepoint = src[i];
+        size_t unit_count = 1;
+
+        if (is_surrogate(codepoint)) {
+            bool paired = codepoint <= 0xDBFF && i + 1 < size && src[i + 1] >= 0xDC00 && src[i + 1] <= 0xDFFF;
+
+            if (mode == Mode::Trust || paired) {
+                codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (src[i + 1] - 0xDC00);
+                unit_count = 2;
+            } else if (mode == Mode::Validate) {
+                result.error = i;
+                return result;
+            } else {
+                if (result.error == UTF_VALID) {
+                    result.error = i;
+                }
+                codepoint = UTF_REPLACEMENT_CHARACTER;
+            }
+        }
+
+        result.written += encode_utf8(codepoint, dst + result.written);
+        i += unit_count;
+    }
+
+    return result;
+}
+
+/// Count the bytes which aren't continuation bytes (10xxxxxx).
+size_t count_utf8_leads(const char *src, size_t size) {
+    size_t count = 0;
+    size_t i = 0;
+
+    // Continuation bytes are the signed bytes below -64.
+    auto threshold = _mm_set1_epi8(-65);
+    for (; i + 16 <= size; i += 16) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        count += std::bitset<16>(_mm_movemask_epi8(_mm_cmpgt_epi8(v, threshold))).count();
+    }
+
+    for (; i < size; i++) {
+        count += ((unsigned char)src[i] & 0xC0) != 0x80;
+    }
+
+    return count;
+}
+
+} // namespace
+
+size_t utf32_length_from_utf8(const char *src, size_t size) {
+    return count_utf8_leads(src, size);
+}
+
+size_t utf16_length_from_utf8(const char *src, size_t size) {
+    // Four-byte sequences take a surrogate pair.
+    size_t four_byte_count = 0;
+    for (size_t i = 0; i < size; i++) {
+        four_byte_count += (unsigned char)src[i] >= 0xF0;
+    }
+    return count_utf8_leads(src, size) + four_byte_count;
+}
+
+size_t utf8_length_from_utf32(const char32_t *src, size_t size) {
+    size_t length = 0;
+    for (size_t i = 0; i < size; i++) {
+        length += utf8_length(src[i]);
+    }
+    return length;
+}
+
+size_t utf8_length_from_utf16(const char16_t *src, size_t size) {
+    size_t length = 0;
+    for (size_t i = 0; i < size; i++) {
+        char16_t unit = src[i];
+        if (unit <= 0xDBFF && unit >= 0xD800 && i + 1 < size && src[i + 1] >= 0xDC00 && src[i + 1] <= 0xDFFF) {
+            length += 4;
+            i++;
+        } else {
+            length += utf8_length(unit);
+        }
+    }
+    return length;
+}
+
+UtfResult convert_utf8_to_utf32(const char *src, size_t size, char32_t *dst) {
+    return utf8_to<Mode::Validate>(src, size, dst);
+}
+
+UtfResult convert_utf8_to_utf16(const char *src, size_t size, char16_t *dst) {
+    return utf8_to<Mode::Validate>(src, size, dst);
+}
+
+UtfResult convert_utf32_to_utf8(const char32_t *src, size_t size, char *dst) {
+    return utf32_to_utf8<Mode::Validate>(src, size, dst);
+}
+
+UtfResult convert_utf16_to_utf8(const char16_t *src, size_t size, char *dst) {
+    return utf16_to_utf8<Mode::Validate>(src, size, dst);
+}
+
+size_t convert_valid_utf8_to_utf32(const char *src, size_t size, char32_t *dst) {
+    return utf8_to<Mode::Trust>(src, size, dst).written;
+}
+
+size_t convert_valid_utf8_to_utf16(const char *src, size_t size, char16_t *dst) {
+    return utf8_to<Mode::Trust>(src, size, dst).written;
+}
+
+size_t convert_valid_utf32_to_utf8(const char32_t *src, size_t size, char *dst) {
+    return utf32_to_utf8<Mode::Trust>(src, size, dst).written;
+}
+
+size_t convert_valid_utf16_to_utf8(const char16_t *src, size_t size, char *dst) {
+    return utf16_to_utf8<Mode::Trust>(src, size, dst).written;
+}
+
+bool utf8_to_utf32(const std::string &source, std::u32string &result) {
+    result.resize(utf32_length_from_utf8(source.data(), source.size()));
+    auto converted = utf8_to<Mode::Validate>(source.data(), source.size(), result.data());
+
+    if (!converted.is_valid()) {
+        // Each invalid byte gives at most one U+FFFD.
+        result.resize(source.size());
+        converted = utf8_to<Mode::Replace>(source.data(), source.size(), result.data());
+    }
+
+    result.resize(converted.written);
+    return converted.is_valid();
+}
+
+bool utf8_to_utf16(const std::string &source, std::u16string &result) {
+    result.resize(utf16_length_from_utf8(source.data(), source.size()));
+    auto converted = utf8_to<Mode::Validate>(source.data(), source.size(), result.data());
+
+    if (!converted.is_valid()) {
+        // No input byte gives more than one code unit.
+        result.resize(source.size());
+        converted = utf8_to<Mode::Replace>(source.data(), source.size(), result.data());
+    }
+
+    result.resize(converted.written);
+    return converted.is_valid();
+}
+
+std::string utf32_to_utf8(const std::u32string &source) {
+    std::string result(utf8_length_from_utf32(source.data(), source.size()), '\0');
+    utf32_to_utf8<Mode::Replace>(source.data(), source.size(), result.data());
+    return result;
+}
+
+std::string utf16_to_utf8(const std::u16string &source) {
+    std::string result(utf8_length_from_utf16(source.data(), source.size()), '\0');
+    utf16_to_utf8<Mode::Replace>(source.data(), source.size(), result.data());
+    return result;
+}
+
+std::string codepoint_to_utf8(char32_t codepoint) {
+    if (!is_valid_codepoint(codepoint)) {
+        codepoint = UTF_REPLACEMENT_CHARACTER;
+    }
+
+    char utf8[4];
+    return {utf8, encode_utf8(codepoint, utf8)};
+}
+
+} // namespace revector
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace revector {
+
+/// UTF-8/UTF-16/UTF-32 transcoding. Runs of ASCII are converted with SIMD.
+///
+/// There are three flavors:
+/// - convert_*() validate, and stop at the first invalid sequence (overlong forms, surrogates, out of range, etc.).
+/// - convert_valid_*() skip validation, for input known to be valid (e.g. produced by the conversions here).
+/// - The string helpers replace invalid sequences with U+FFFD.
+///
+/// The pointer variants write to buffers sized by the *_length_from_*() functions.
+
+const size_t UTF_VALID = SIZE_MAX;
+
+const char32_t UTF_REPLACEMENT_CHARACTER = 0xFFFD;
+
+struct UtfResult {
+    /// Code units written.
+    size_t written = 0;
+
+    /// Input offset (in code units) of the first invalid sequence, or UTF_VALID.
+    size_t error = UTF_VALID;
+
+    bool is_valid() const {
+        return error == UTF_VALID;
+    }
+};
+
+/// Exact for valid input.
+size_t utf32_length_from_utf8(const char *src, size_t size);
+
+/// Exact for valid input.
+size_t utf16_length_from_utf8(const char *src, size_t size);
+
+/// Exact, counting invalid codepoints as U+FFFD.
+size_t utf8_length_from_utf32(const char32_t *src, size_t size);
+
+/// Exact, counting unpaired surrogates as U+FFFD.
+size_t utf8_length_from_utf16(const char16_t *src, size_t size);
+
+UtfResult convert_utf8_to_utf32(const char *src, size_t size, char32_t *dst);
+
+UtfResult convert_utf8_to_utf16(const char *src, size_t size, char16_t *dst);
+
+UtfResult convert_utf32_to_utf8(const char32_t *src, size_t size, char *dst);
+
+UtfResult convert_utf16_to_utf8(const char16_t *src, size_t size, char *dst);
+
+/// Returns the code units written.
+size_t convert_valid_utf8_to_utf32(const char *src, size_t size, char32_t *dst);
+
+size_t convert_valid_utf8_to_utf16(const char *src, size_t size, char16_t *dst);
+
+size_t convert_valid_utf32_to_utf8(const char32_t *src, size_t size, char *dst);
+
+size_t convert_valid_utf16_to_utf8(const char16_t *src, size_t size, char *dst);
+
+/// Returns false if invalid sequences were replaced.
+bool utf8_to_utf32(const std::string &source, std::u32string &result);
+
+bool utf8_to_utf16(const std::string &source, std::u16string &result);
+
+std::string utf32_to_utf8(const std::u32string &source);
+
+std::string utf16_to_utf8(const std::u16string &source);
+
+/// An invalid codepoint gives U+FFFD.
+std::string codepoint_to_utf8(char32_t codepoint);
+
+} // namespace revector
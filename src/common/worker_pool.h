@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "signal.h"
+
+namespace revector {
+
+/// A fixed number of threads running tasks in submission order.
+/// Threads are only started with the first task. Tasks still queued on destruction are dropped.
+class WorkerPool {
+public:
+    using Task = Callable<void()>;
+
+    /// Zero means one thread less than the hardware threads, and at least one.
+    explicit WorkerPool(uint32_t _thread_count = 0) : thread_count(_thread_count) {
+        if (thread_count == 0) {
+            thread_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        }
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            tasks.clear();
+        }
+        condition.notify_all();
+
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+
+    void submit(Task task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+
+            if (threads.empty()) {
+                for (uint32_t i = 0; i < thread_count; i++) {
+                    threads.emplace_back([this] { run(); });
+                }
+            }
+        }
+        condition.notify_one();
+    }
+
+private:
+    void run() {
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+
+                if (stopping) {
+                    return;
+                }
+
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+
+            task();
+        }
+    }
+
+    uint32_t thread_count;
+
+    std::vector<std::thread> threads;
+
+    std::deque<Task> tasks;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+
+    bool stopping = false;
+};
+
+} // namespace revector
@@ -1,6 +1,7 @@
 #include "node.h"
 
 #include <string>
+#include <unordered_map>
 
 #include "../servers/render_server.h"
 #include "sub_window.h"
@@ -20,6 +21,9 @@ const char *NodeNames[] = {
     "VBoxContainer",
     "ScrollContainer",
     "TabContainer",
+    "CollapseContainer",
+    "VirtualListContainer",
+    "CanvasGroup",
 
     "Button",
     "MenuButton",
@@ -45,6 +49,29 @@ std::string get_node_type_name(NodeType type) {
     return NodeNames[(uint32_t)type];
 }
 
+SignalId get_signal_id(const std::string &name) {
+    static const std::unordered_map<std::string, SignalId> signal_ids = {
+        {"subtree_changed", SignalId::SubtreeChanged},
+        {"cursor_entered", SignalId::CursorEntered},
+        {"cursor_exited", SignalId::CursorExited},
+        {"focus_released", SignalId::FocusReleased},
+        {"pressed", SignalId::Pressed},
+        {"toggled", SignalId::Toggled},
+        {"timeout", SignalId::Timeout},
+        {"item_selected", SignalId::ItemSelected},
+        {"popup_hide", SignalId::PopupHide},
+        {"focused", SignalId::Focused},
+        {"value_changed", SignalId::ValueChanged},
+        {"on_value_changed", SignalId::ValueChanged},
+    };
+
+    auto iter = signal_ids.find(name);
+    if (iter == signal_ids.end()) {
+        return SignalId::Unknown;
+    }
+    return iter->second;
+}
+
 void dfs_preorder_ltr_traversal(Node *node, std::vector<Node *> &ordered_nodes) {
     if (node == nullptr) {
         return;
@@ -129,7 +156,8 @@ std::vector<std::shared_ptr<Node>> Node::get_all_children() {
 void Node::add_child(const std::shared_ptr<Node> &new_child) {
     assert(new_child && new_child.get() != this);
 
-    if (std::find(children.begin(), children.end(), new_child) != children.end()) {
+    // A node can only have one parent, so checking the parent is enough.
+    if (new_child->parent == this) {
         std::cout << "Attempted to add a repeated child!" << std::endl;
         return;
     }
@@ -137,12 +165,36 @@ void Node::add_child(const std::shared_ptr<Node> &new_child) {
     // Set self as the parent of the new node.
     new_child->parent = this;
     new_child->tree_ = tree_;
+    new_child->update_global_visibility();
 
     children.push_back(new_child);
+
+    when_subtree_changed();
+}
+
+void Node::add_children(gsl::span<const std::shared_ptr<Node>> new_children) {
+    children.reserve(children.size() + new_children.size());
+
+    for (auto &new_child : new_children) {
+        assert(new_child && new_child.get() != this);
+
+        if (new_child->parent == this) {
+            std::cout << "Attempted to add a repeated child!" << std::endl;
+            continue;
+        }
+
+        new_child->parent = this;
+        new_child->tree_ = tree_;
+        new_child->update_global_visibility();
+
+        children.push_back(new_child);
+    }
+
+    when_subtree_changed();
 }
 
 void Node::add_embedded_child(const std::shared_ptr<Node> &new_child) {
-    if (std::find(embedded_children.begin(), embedded_children.end(), new_child) != embedded_children.end()) {
+    if (new_child->parent == this) {
         std::cout << "Attempted to add a repeated embedded child!" << std::endl;
         return;
     }
@@ -150,8 +202,11 @@ void Node::add_embedded_child(const std::shared_ptr<Node> &new_child) {
     // Set self as the parent of the new node.
     new_child->parent = this;
     new_child->tree_ = tree_;
+    new_child->update_global_visibility();
 
     embedded_children.push_back(new_child);
+
+    when_subtree_changed();
 }
 
 std::shared_ptr<Node> Node::get_child(size_t index) {
@@ -162,19 +217,41 @@ std::shared_ptr<Node> Node::get_child(size_t index) {
     return children[index];
 }
 
-void Node::remove_child(size_t index) {
-    if (index < 0 || index >= children.size()) {
+void Node::remove_child(size_t index, bool keep_order) {
+    if (index >= children.size()) {
         return;
     }
-    children.erase(children.begin() + index);
+
+    children[index]->parent = nullptr;
+    children[index]->update_global_visibility();
+
+    if (keep_order) {
+        children.erase(children.begin() + index);
+    } else {
+        std::swap(children[index], children.back());
+        children.pop_back();
+    }
+
+    when_subtree_changed();
 }
 
 void Node::remove_all_children() {
+    for (auto &child : children) {
+        child->parent = nullptr;
+        child->update_global_visibility();
+    }
     children.clear();
+
+    when_subtree_changed();
 }
 
 void Node::set_visibility(bool visible) {
+    if (visible_ != visible && parent) {
+        parent->queue_redraw();
+    }
+
     visible_ = visible;
+    update_global_visibility();
 }
 
 bool Node::get_visibility() const {
@@ -182,11 +259,65 @@ bool Node::get_visibility() const {
 }
 
 bool Node::get_global_visibility() const {
+    return global_visible_;
+}
+
+void Node::update_global_visibility() {
+    bool global_visible = visible_ && (parent == nullptr || parent->global_visible_);
+
+    // Descendants are up to date if this node is.
+    if (global_visible == global_visible_) {
+        return;
+    }
+    global_visible_ = global_visible;
+
+    for (auto &child : embedded_children) {
+        child->update_global_visibility();
+    }
+    for (auto &child : children) {
+        child->update_global_visibility();
+    }
+}
+
+void Node::set_process_mode(ProcessMode mode) {
+    process_mode = mode;
+}
+
+ProcessMode Node::get_process_mode() const {
+    return process_mode;
+}
+
+ProcessMode Node::get_effective_process_mode() const {
+    if (process_mode != ProcessMode::Inherit) {
+        return process_mode;
+    }
+
     if (parent) {
-        return parent->get_global_visibility() && get_visibility();
+        return parent->get_effective_process_mode();
     }
 
-    return get_visibility();
+    return ProcessMode::WhenVisible;
+}
+
+ProcessMode Node::resolve_process_mode(ProcessMode parent_mode) const {
+    return process_mode == ProcessMode::Inherit ? parent_mode : process_mode;
+}
+
+bool Node::can_process(ProcessMode effective_mode, bool paused) const {
+    switch (effective_mode) {
+        case ProcessMode::Always:
+            return true;
+        case ProcessMode::WhenPaused:
+            return paused && global_visible_;
+        case ProcessMode::Disabled:
+            return false;
+        default:
+            return !paused && global_visible_;
+    }
+}
+
+bool Node::is_ready() const {
+    return ready_;
 }
 
 uint8_t Node::get_window_index() const {
@@ -219,19 +350,71 @@ void Node::when_parent_size_changed(Vec2F new_size) {
 }
 
 void Node::when_subtree_changed() {
-    for (auto &callback : subtree_changed_callbacks) {
-        callback();
+    // Branch->root propagation. Stop at a marked ancestor, as its ancestors are marked already.
+    for (auto node = this; node && !node->subtree_changed_; node = node->parent) {
+        node->subtree_changed_ = true;
     }
 
-    // Branch->root signal propagation.
-    if (parent) {
-        parent->when_subtree_changed();
+    queue_redraw();
+}
+
+void Node::flush_subtree_changed() {
+    if (!subtree_changed_) {
+        return;
+    }
+
+    // Clear before notifying, so that changes made by the callbacks are marked again for the next flush.
+    subtree_changed_ = false;
+
+    for (auto &child : get_all_children()) {
+        child->flush_subtree_changed();
+    }
+
+    subtree_changed_signal.emit();
+}
+
+void Node::queue_redraw() {
+    // Same as subtree changes, marked nodes always have marked ancestors.
+    for (auto node = this; node && !node->redraw_queued_; node = node->parent) {
+        node->redraw_queued_ = true;
+    }
+}
+
+bool Node::is_redraw_queued() const {
+    return redraw_queued_;
+}
+
+bool Node::consume_redraw() {
+    if (!redraw_queued_) {
+        return false;
+    }
+
+    redraw_queued_ = false;
+
+    // Only marked descendants need to be visited.
+    for (auto &child : children) {
+        child->consume_redraw();
+    }
+    for (auto &child : embedded_children) {
+        child->consume_redraw();
     }
+
+    return true;
 }
 
 void Node::connect_signal(const std::string &signal, const AnyCallable<void> &callback) {
-    if (signal == "subtree_changed") {
-        subtree_changed_callbacks.push_back(callback);
+    auto signal_id = get_signal_id(signal);
+    if (signal_id == SignalId::Unknown) {
+        Logger::error("Attempted to connect an unknown signal: " + signal, "revector");
+        return;
+    }
+
+    connect_signal(signal_id, callback);
+}
+
+void Node::connect_signal(SignalId signal, const AnyCallable<void> &callback) {
+    if (signal == SignalId::SubtreeChanged) {
+        subtree_changed_signal.connect(make_typed_slot<>(callback));
     }
 }
 
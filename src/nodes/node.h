@@ -1,9 +1,12 @@
 #pragma once
 
+#include <gsl/span>
 #include <memory>
 #include <vector>
 
 #include "../common/any_callable.h"
+#include "../common/pool_allocator.h"
+#include "../common/signal.h"
 #include "../common/utils.h"
 #include "../servers/engine.h"
 #include "../servers/input_server.h"
@@ -26,6 +29,8 @@ enum class NodeType {
     ScrollContainer,
     TabContainer,
     CollapseContainer,
+    VirtualListContainer,
+    CanvasGroup,
 
     Button,
     MenuButton,   // todo
@@ -49,6 +54,41 @@ enum class NodeType {
 
 std::string get_node_type_name(NodeType type);
 
+/// Built-in node signals that can be connected by name.
+enum class SignalId {
+    SubtreeChanged = 0,
+
+    CursorEntered,
+    CursorExited,
+    FocusReleased,
+
+    Pressed,
+    Toggled,
+
+    Timeout,
+
+    ItemSelected,
+    PopupHide,
+
+    Focused,
+    ValueChanged,
+
+    Unknown,
+};
+
+SignalId get_signal_id(const std::string &name);
+
+/// When the scene tree processes (input, layout and update) a node.
+/// Skipping a node skips its whole subtree, descendants can't override that.
+/// Hidden nodes never receive input.
+enum class ProcessMode {
+    Inherit,     // Use the parent's mode. Nodes without a parent use WhenVisible.
+    WhenVisible, // Process when globally visible and the tree is not paused.
+    Always,      // Process even when hidden or the tree is paused.
+    WhenPaused,  // Process only when globally visible and the tree is paused.
+    Disabled,    // Never process.
+};
+
 class SceneTree;
 
 /// Position-independent, window-independent base node.
@@ -85,6 +125,11 @@ public:
     virtual void post_draw_children() {
     }
 
+    /// If true, draw_system won't draw the children, as the node draws them in pre/post_draw_children().
+    virtual bool draws_children_itself() const {
+        return false;
+    }
+
     virtual void custom_ready() {
     }
 
@@ -99,6 +144,9 @@ public:
 
     virtual void add_child(const std::shared_ptr<Node> &new_child);
 
+    /// Add children in bulk, which is much faster than calling add_child() repeatedly for large lists.
+    virtual void add_children(gsl::span<const std::shared_ptr<Node>> new_children);
+
     void add_embedded_child(const std::shared_ptr<Node> &new_child);
 
     NodeType get_node_type() const;
@@ -111,7 +159,9 @@ public:
 
     virtual std::shared_ptr<Node> get_child(size_t index);
 
-    void remove_child(size_t index);
+    /// @param keep_order If false, the last child is moved to the removed index instead of shifting all
+    /// following children, which is O(1).
+    void remove_child(size_t index, bool keep_order = true);
 
     void remove_all_children();
 
@@ -125,23 +175,70 @@ public:
 
     bool get_visibility() const;
 
+    /// Cached, so it's cheap to call.
     bool get_global_visibility() const;
 
+    void set_process_mode(ProcessMode mode);
+
+    ProcessMode get_process_mode() const;
+
+    /// Process mode with Inherit resolved by walking up the ancestors.
+    ProcessMode get_effective_process_mode() const;
+
+    /// Resolve Inherit with the parent's effective mode, for top-down traversals.
+    ProcessMode resolve_process_mode(ProcessMode parent_mode) const;
+
+    /// Check if the node should be processed under its effective process mode.
+    /// Doesn't check ancestors, which are expected to be processed already.
+    bool can_process(ProcessMode effective_mode, bool paused) const;
+
+    bool is_ready() const;
+
     uint8_t get_window_index() const;
 
     virtual void when_parent_size_changed(Vec2F new_size);
 
     /**
      * Called when the subtree structure of this node changed.
+     * Notifications are batched: this only marks the node and its ancestors as changed,
+     * and subtree_changed_signal is emitted once per frame by the scene tree.
      */
     void when_subtree_changed();
 
-    virtual void connect_signal(const std::string &signal, const AnyCallable<void> &callback);
+    /// Emit the pending subtree change notifications in this subtree, children before parents.
+    void flush_subtree_changed();
+
+    /**
+     * Mark the node as changed in appearance.
+     * The mark propagates to the ancestors like subtree changes, so that nodes caching the rendering
+     * of their descendants (e.g. CanvasGroup) only draw them again when something below has changed.
+     *
+     * Content cached this way must queue a redraw whenever what it draws changes. The built-in UI nodes do so
+     * through their setters and NodeUi::hash_draw_state(). Changes they can't detect must be followed by a call:
+     * changing what custom_draw() draws, assigning public theme fields (e.g. Button::theme_normal) directly,
+     * and changing the pixels of a texture or a RenderImage in place.
+     */
+    void queue_redraw();
+
+    /// Check if a redraw was queued in this subtree since the marks were last consumed.
+    bool is_redraw_queued() const;
+
+    /// Clear the redraw marks of this subtree. Returns if there were any.
+    /// Caching nodes should consume after drawing their descendants, so that nested caches see their own marks.
+    bool consume_redraw();
+
+    /// Connect a callback by signal name. Connecting to the typed signals directly is preferred.
+    void connect_signal(const std::string &signal, const AnyCallable<void> &callback);
+
+    virtual void connect_signal(SignalId signal, const AnyCallable<void> &callback);
 
     SceneTree *get_tree() const;
 
     int render_layer = 0;
 
+    // Called when subtree structure changes.
+    TypedSignal<> subtree_changed_signal;
+
 protected:
     NodeType type = NodeType::Node;
 
@@ -149,6 +246,8 @@ protected:
 
     bool visible_ = true;
 
+    ProcessMode process_mode = ProcessMode::Inherit;
+
     std::vector<std::shared_ptr<Node>> children;
 
     std::vector<std::shared_ptr<Node>> embedded_children;
@@ -159,10 +258,26 @@ protected:
 
     SceneTree *tree_;
 
-    // Called when subtree structure changes.
-    std::vector<AnyCallable<void>> subtree_changed_callbacks;
+private:
+    /// Refresh the cached global visibility of this subtree after a visibility or parent change.
+    void update_global_visibility();
+
+    bool global_visible_ = true;
+
+    /// If set, all ancestors are set too.
+    bool subtree_changed_ = false;
+
+    /// If set, all ancestors are set too.
+    bool redraw_queued_ = false;
 };
 
+/// Create a node using a pooled allocator.
+/// Prefer this over std::make_shared when creating a large number of nodes.
+template <typename T, typename... Args>
+std::shared_ptr<T> make_node(Args &&...args) {
+    return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
 /// Perform a depth-first-search preorder traversal from left-to-right.
 /// Usages: draw nodes back-to-front, propagate transform.
 /// See: https://faculty.cs.niu.edu/~mcmahon/CS241/Notes/Data_Structures/binary_tree_traversals.html
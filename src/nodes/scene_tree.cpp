@@ -1,5 +1,6 @@
 #include "scene_tree.h"
 
+#include "../resources/resource_manager.h"
 #include "../servers/render_server.h"
 #include "sub_window.h"
 
@@ -14,8 +15,16 @@ SceneTree::SceneTree() {
     root->tree_ = this;
 }
 
-void propagate_input(Node* node, InputEvent& event) {
-    if (!node->get_visibility()) {
+/// Effective process mode of the parent, to start a top-down traversal from a node.
+ProcessMode get_parent_process_mode(Node* node) {
+    auto parent = node->get_parent();
+    return parent ? parent->get_effective_process_mode() : ProcessMode::WhenVisible;
+}
+
+void propagate_input(Node* node, ProcessMode parent_mode, bool paused, InputEvent& event) {
+    auto mode = node->resolve_process_mode(parent_mode);
+
+    if (!node->get_visibility() || !node->can_process(mode, paused)) {
         return;
     }
 
@@ -48,13 +57,13 @@ void propagate_input(Node* node, InputEvent& event) {
             }
         }
 
-        propagate_input(child.get(), event);
+        propagate_input(child.get(), mode, paused, event);
     }
 
     node->input(event);
 }
 
-void input_system(Node* root, std::vector<InputEvent>& input_queue) {
+void input_system(Node* root, std::vector<InputEvent>& input_queue, bool paused) {
     // Collect all sub-windows.
     std::vector<SubWindow*> sub_windows;
     {
@@ -79,7 +88,7 @@ void input_system(Node* root, std::vector<InputEvent>& input_queue) {
                 continue;
             }
 
-            propagate_input(w, event);
+            propagate_input(w, get_parent_process_mode(w), paused, event);
         }
     }
 
@@ -88,7 +97,7 @@ void input_system(Node* root, std::vector<InputEvent>& input_queue) {
         //     continue;
         // }
 
-        propagate_input(root, event);
+        propagate_input(root, get_parent_process_mode(root), paused, event);
     }
 }
 
@@ -132,21 +141,40 @@ void transform_system(Node* root) {
 }
 
 void propagate_draw(Node* node) {
-    node->draw();
+    bool culled = false;
 
-    node->pre_draw_children();
+    if (node->is_ui_node()) {
+        culled = dynamic_cast<NodeUi*>(node)->is_outside_clip_rect();
 
-    for (auto& child : node->get_all_children()) {
-        if (typeid(*child) == typeid(SubWindow) || !node->get_visibility()) {
-            continue;
+        // Containers lay out their children inside their own rect, so the whole subtree can be skipped.
+        if (culled && dynamic_cast<Container*>(node)) {
+            return;
         }
+    }
 
-        propagate_draw(child.get());
+    if (!culled) {
+        node->draw();
+    }
+
+    node->pre_draw_children();
+
+    if (!node->draws_children_itself()) {
+        for (auto& child : node->get_all_children()) {
+            if (typeid(*child) == typeid(SubWindow) || !node->get_visibility()) {
+                continue;
+            }
+
+            propagate_draw(child.get());
+        }
     }
 
     node->post_draw_children();
 }
 
+void draw_subtree(Node* root) {
+    propagate_draw(root);
+}
+
 void draw_system(Node* root) {
     // Collect all sub-windows.
 
@@ -170,28 +198,73 @@ void draw_system(Node* root) {
 
         w->pre_draw_children();
 
+        auto window = RenderServer::get_singleton()->window_builder_->get_window(w->get_window_index());
+        VectorServer::get_singleton()->push_clip_rect(RectF({}, window.lock()->get_logical_size().to_f32()));
+
         // DRAW
         propagate_draw(w);
 
+        VectorServer::get_singleton()->pop_clip_rect();
+
         w->post_draw_children();
     }
 
+    auto window = RenderServer::get_singleton()->window_builder_->get_window(root->get_window_index());
+
     VectorServer::get_singleton()->set_global_scale(
         RenderServer::get_singleton()->window_builder_->get_window(0).lock()->get_dpi_scaling_factor());
+
+    // Nodes outside the window are culled.
+    VectorServer::get_singleton()->push_clip_rect(RectF({}, window.lock()->get_logical_size().to_f32()));
+
     propagate_draw(root);
+
+    VectorServer::get_singleton()->pop_clip_rect();
 }
 
-void calc_minimum_size(Node* root) {
-    std::vector<Node*> descendants;
-    dfs_postorder_ltr_traversal(root, descendants);
-    for (auto& node : descendants) {
+void propagate_calc_minimum_size(Node* node, ProcessMode parent_mode, bool paused) {
+    auto mode = node->resolve_process_mode(parent_mode);
+
+    if (!node->can_process(mode, paused)) {
+        return;
+    }
+
+    for (auto& child : node->get_all_children()) {
+        propagate_calc_minimum_size(child.get(), mode, paused);
+    }
+
+    if (node->is_ui_node()) {
+        auto ui_node = dynamic_cast<NodeUi*>(node);
+        ui_node->calc_minimum_size();
+        // std::cout << "Node: " << get_node_type_name(node->type)
+        //           << ", size: " << ui_node->get_effective_minimum_size() << std::endl;
+    }
+}
+
+void calc_minimum_size(Node* root, bool paused) {
+    propagate_calc_minimum_size(root, get_parent_process_mode(root), paused);
+}
+
+/// Nodes are updated before their children, so a parent can change which children get processed
+/// (e.g. switching the visible tab) in the same frame.
+void propagate_update(Node* node, ProcessMode parent_mode, bool paused, double dt) {
+    auto mode = node->resolve_process_mode(parent_mode);
+
+    if (!node->can_process(mode, paused)) {
+        return;
+    }
+
+    if (node->is_ready()) {
+        node->update(dt);
+
         if (node->is_ui_node()) {
-            auto ui_node = dynamic_cast<NodeUi*>(node);
-            ui_node->calc_minimum_size();
-            // std::cout << "Node: " << get_node_type_name(node->type)
-            //           << ", size: " << ui_node->get_effective_minimum_size() << std::endl;
+            dynamic_cast<NodeUi*>(node)->check_draw_state();
         }
     }
+
+    for (auto& child : node->get_all_children()) {
+        propagate_update(child.get(), mode, paused, dt);
+    }
 }
 
 void SceneTree::process(double dt) {
@@ -213,25 +286,25 @@ void SceneTree::process(double dt) {
         }
     }
 
-    input_system(root.get(), InputServer::get_singleton()->input_queue);
+    input_system(root.get(), InputServer::get_singleton()->input_queue, paused);
+
+    // Complete background resource loads, emitting their signals on the main thread.
+    ResourceManager::get_singleton()->poll();
+
+    // Dispatch deferred signal emissions in one batch.
+    SignalQueue::get_singleton()->flush();
+
+    // Notify structural changes of this frame once per changed node, before layout.
+    root->flush_subtree_changed();
 
     // Run calc_minimum_size() depth-first.
-    calc_minimum_size(root.get());
+    calc_minimum_size(root.get(), paused);
 
     // Update global transform.
     transform_system(root.get());
 
-    // Update from-back-to-front.
-    {
-        std::vector<Node*> nodes;
-        dfs_preorder_ltr_traversal(root.get(), nodes);
-        for (auto& node : nodes) {
-            if (!node->ready_) {
-                continue;
-            }
-            node->update(dt);
-        }
-    }
+    // Update from-back-to-front, skipping subtrees according to their process modes.
+    propagate_update(root.get(), get_parent_process_mode(root.get()), paused, dt);
 
     // Draw from-back-to-front.
     draw_system(root.get());
@@ -259,6 +332,14 @@ void SceneTree::quit() {
     quited = true;
 }
 
+void SceneTree::set_paused(bool new_paused) {
+    paused = new_paused;
+}
+
+bool SceneTree::is_paused() const {
+    return paused;
+}
+
 bool SceneTree::has_quited() const {
     return quited;
 }
@@ -6,11 +6,13 @@
 #include "ui/button.h"
 #include "ui/check_button.h"
 #include "ui/container/box_container.h"
+#include "ui/container/canvas_group.h"
 #include "ui/container/collapse_container.h"
 #include "ui/container/grid_container.h"
 #include "ui/container/margin_container.h"
 #include "ui/container/scroll_container.h"
 #include "ui/container/tab_container.h"
+#include "ui/container/virtual_list_container.h"
 #include "ui/label.h"
 #include "ui/menu_button.h"
 #include "ui/panel.h"
@@ -31,8 +33,11 @@ void transform_system(Node* root);
 
 void draw_system(Node* root);
 
-/// Run calc_minimum_size() depth-first.
-void calc_minimum_size(Node* root);
+/// Draw a subtree onto the current scene of the vector server, without touching windows or clip rects.
+void draw_subtree(Node* root);
+
+/// Run calc_minimum_size() depth-first, skipping subtrees according to their process modes.
+void calc_minimum_size(Node* root, bool paused = false);
 
 /// Processing order: Input -> Update -> Draw.
 class SceneTree {
@@ -53,12 +58,19 @@ public:
 
     bool has_quited() const;
 
+    /// Nodes are processed according to their process modes when the tree is paused.
+    void set_paused(bool new_paused);
+
+    bool is_paused() const;
+
     std::weak_ptr<Pathfinder::Window> get_primary_window() const;
 
 private:
     std::shared_ptr<Node> root;
 
     bool quited = false;
+
+    bool paused = false;
 };
 
 } // namespace revector
@@ -114,7 +114,12 @@ void SubWindow::set_visibility(bool visible) {
         return;
     }
 
-    visible_ = visible;
+    Node::set_visibility(visible);
+
+    // A hidden window is not processed, so it must be hidden here instead of in update().
+    if (!visible_) {
+        get_raw_window()->hide();
+    }
 }
 
 std::shared_ptr<Pathfinder::Window> SubWindow::get_raw_window() const {
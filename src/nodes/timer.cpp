@@ -28,11 +28,11 @@ void Timer::update(double dt) {
     }
 }
 
-void Timer::connect_signal(const std::string& signal, const AnyCallable<void>& callback) {
+void Timer::connect_signal(SignalId signal, const AnyCallable<void>& callback) {
     Node::connect_signal(signal, callback);
 
-    if (signal == "timeout") {
-        timeout_callbacks.emplace_back(callback);
+    if (signal == SignalId::Timeout) {
+        timeout_signal.connect(make_typed_slot<>(callback));
     }
 }
 
@@ -50,9 +50,7 @@ void Timer::stop() {
 }
 
 void Timer::emit_timeout() {
-    for (auto& c : timeout_callbacks) {
-        c();
-    }
+    timeout_signal.emit();
 }
 
 } // namespace revector
@@ -16,7 +16,9 @@ public:
 
     void update(double dt) override;
 
-    void connect_signal(const std::string& signal, const AnyCallable<void>& callback) override;
+    using Node::connect_signal;
+
+    void connect_signal(SignalId signal, const AnyCallable<void>& callback) override;
 
     float get_remaining_time() const;
 
@@ -24,12 +26,13 @@ public:
 
     void stop();
 
+    TypedSignal<> timeout_signal;
+
 protected:
     void emit_timeout();
 
     bool is_stopped_ = true;
     double remaining_time_ = 0;
-    std::vector<AnyCallable<void>> timeout_callbacks;
 };
 
 } // namespace revector
@@ -22,7 +22,7 @@ Button::Button() {
     theme_disabled = default_theme->button.styles["disabled"];
 
     // Don't add the label as a child since it's not a normal node but part of the button.
-    label = std::make_shared<Label>();
+    label = make_node<Label>();
     label->set_text("Button");
     label->set_mouse_filter(MouseFilter::Ignore);
     label->set_horizontal_alignment(Alignment::Center);
@@ -32,17 +32,17 @@ Button::Button() {
     label->container_sizing.expand_h = true;
     label->container_sizing.flag_h = ContainerSizingFlag::Fill;
 
-    icon_rect = std::make_shared<TextureRect>();
+    icon_rect = make_node<TextureRect>();
     icon_rect->set_stretch_mode(TextureRect::StretchMode::KeepCentered);
     icon_rect->set_mouse_filter(MouseFilter::Ignore);
 
-    hbox_container = std::make_shared<HBoxContainer>();
+    hbox_container = make_node<HBoxContainer>();
     hbox_container->add_child(icon_rect);
     hbox_container->add_child(label);
     hbox_container->set_separation(2);
     hbox_container->set_mouse_filter(MouseFilter::Ignore);
 
-    margin_container = std::make_shared<MarginContainer>();
+    margin_container = make_node<MarginContainer>();
     margin_container->set_margin_all(4);
     margin_container->add_child(hbox_container);
     margin_container->set_size(size);
@@ -50,10 +50,10 @@ Button::Button() {
 
     add_embedded_child(margin_container);
 
-    callbacks_cursor_entered.emplace_back(
+    cursor_entered_signal.connect(
         [this] { InputServer::get_singleton()->set_cursor(get_window_index(), CursorShape::Hand); });
 
-    callbacks_cursor_exited.emplace_back(
+    cursor_exited_signal.connect(
         [this] { InputServer::get_singleton()->set_cursor(get_window_index(), CursorShape::Arrow); });
 }
 
@@ -203,6 +203,17 @@ void Button::draw() {
     NodeUi::draw();
 }
 
+void Button::hash_draw_state(Pathfinder::Hasher &hasher) const {
+    NodeUi::hash_draw_state(hasher);
+
+    hasher.write_u64(pressed);
+    hasher.write_u64(hovered);
+    hasher.write_u64(flat_);
+    hasher.write_u64(disabled_);
+    hasher.write_u64((uint64_t)icon_normal_.get());
+    hasher.write_u64((uint64_t)icon_pressed_.get());
+}
+
 void Button::set_position(Vec2F new_position) {
     position = new_position;
 }
@@ -222,29 +233,25 @@ void Button::set_size(Vec2F p_size) {
 }
 
 void Button::when_pressed() {
-    for (auto &callback : pressed_callbacks) {
-        callback();
-    }
+    pressed_signal.emit();
 }
 
 void Button::when_toggled(bool pressed) {
-    for (auto &callback : toggled_callbacks) {
-        try {
-            callback.operator()<bool>(std::move(pressed));
-        } catch (std::bad_any_cast &) {
-            Logger::error("Mismatched signal argument types!", "revector");
-        }
-    }
+    toggled_signal.emit(pressed);
 }
 
-void Button::connect_signal(const std::string &signal, const AnyCallable<void> &callback) {
+void Button::connect_signal(SignalId signal, const AnyCallable<void> &callback) {
     NodeUi::connect_signal(signal, callback);
 
-    if (signal == "pressed") {
-        pressed_callbacks.push_back(callback);
-    }
-    if (signal == "toggled") {
-        toggled_callbacks.push_back(callback);
+    switch (signal) {
+        case SignalId::Pressed: {
+            pressed_signal.connect(make_typed_slot<>(callback));
+        } break;
+        case SignalId::Toggled: {
+            toggled_signal.connect(make_typed_slot<bool>(callback));
+        } break;
+        default:
+            break;
     }
 }
 
@@ -304,8 +311,7 @@ void ButtonGroup::update() {
 void ButtonGroup::add_button(const std::weak_ptr<Button> &new_button) {
     buttons.push_back(new_button);
 
-    auto callback = [this, new_button] { pressed_button = new_button; };
-    new_button.lock()->connect_signal("pressed", callback);
+    new_button.lock()->pressed_signal.connect([this, new_button] { pressed_button = new_button; });
 }
 
 } // namespace revector
@@ -29,7 +29,9 @@ public:
 
     void calc_minimum_size() override;
 
-    void connect_signal(const std::string &signal, const AnyCallable<void> &callback) override;
+    using NodeUi::connect_signal;
+
+    void connect_signal(SignalId signal, const AnyCallable<void> &callback) override;
 
     void set_text(const std::string &text);
 
@@ -64,6 +66,10 @@ public:
     StyleBox theme_pressed;
     StyleBox theme_disabled;
 
+    // Signals.
+    TypedSignal<> pressed_signal;
+    TypedSignal<bool> toggled_signal;
+
 protected:
     /**
      * Pressed == ture && hovered == true: Normal buttons
@@ -91,16 +97,11 @@ protected:
     std::shared_ptr<Image> icon_normal_;
     std::shared_ptr<Image> icon_pressed_;
 
-    // Callbacks.
-    std::vector<AnyCallable<void>> pressed_callbacks;
-    std::vector<AnyCallable<void>> toggled_callbacks;
-    std::vector<AnyCallable<void>> hovered_callbacks;
-    std::vector<AnyCallable<void>> down_callbacks;
-    std::vector<AnyCallable<void>> up_callbacks;
-
     void when_pressed();
 
     void when_toggled(bool pressed);
+
+    void hash_draw_state(Pathfinder::Hasher &hasher) const override;
 };
 
 class ButtonGroup {
@@ -111,8 +112,6 @@ public:
 
     std::vector<std::weak_ptr<Button>> buttons;
     std::weak_ptr<Button> pressed_button;
-
-    std::vector<AnyCallable<void>> pressed_callbacks;
 };
 
 } // namespace revector
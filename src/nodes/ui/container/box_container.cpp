@@ -54,7 +54,8 @@ void BoxContainer::adjust_layout() {
         float occupied_space = real_space;
 
         if (extra_space_for_each_expanding_child > 0) {
-            if (std::find(expanding_children.begin(), expanding_children.end(), ui_child) != expanding_children.end()) {
+            bool expanding = horizontal ? ui_child->container_sizing.expand_h : ui_child->container_sizing.expand_v;
+            if (expanding) {
                 occupied_space += extra_space_for_each_expanding_child;
             }
         }
@@ -0,0 +1,140 @@
+#include "canvas_group.h"
+
+#include "../../scene_tree.h"
+#include "../../sub_window.h"
+
+namespace revector {
+
+CanvasGroup::CanvasGroup() {
+    type = NodeType::CanvasGroup;
+}
+
+void CanvasGroup::set_opacity(float new_opacity) {
+    opacity = std::clamp(new_opacity, 0.0f, 1.0f);
+}
+
+float CanvasGroup::get_opacity() const {
+    return opacity;
+}
+
+void CanvasGroup::set_group_transform(const Transform2 &new_transform) {
+    group_transform = new_transform;
+}
+
+Transform2 CanvasGroup::get_group_transform() const {
+    return group_transform;
+}
+
+void CanvasGroup::invalidate() {
+    dirty = true;
+}
+
+void CanvasGroup::set_auto_invalidate(bool enabled) {
+    auto_invalidate = enabled;
+}
+
+bool CanvasGroup::get_auto_invalidate() const {
+    return auto_invalidate;
+}
+
+void CanvasGroup::pre_draw_children() {
+    // A zero-sized texture is not allowed.
+    temp_draw_data.skipped = !visible_ || size.is_any_zero();
+    if (temp_draw_data.skipped) {
+        return;
+    }
+
+    float dpi_scale = RenderServer::get_singleton()->window_builder_->get_dpi_scaling_factor(get_window_index());
+
+    auto new_texture_size = (size * dpi_scale).ceil();
+
+    if (new_texture_size != texture_size) {
+        texture_size = new_texture_size;
+        textures = {};
+        scene = std::make_shared<Pathfinder::Scene>(0, RectF({}, texture_size.to_f32()));
+        dirty = true;
+    }
+
+    // Added, removed and changed descendants all queue a redraw.
+    if (is_redraw_queued()) {
+        dirty = true;
+    }
+
+    if (dirty || auto_invalidate) {
+        render_children();
+    }
+
+    // After rendering, as nested caches check their own marks while being drawn.
+    consume_redraw();
+}
+
+void CanvasGroup::post_draw_children() {
+    if (temp_draw_data.skipped || !textures[front_texture]) {
+        return;
+    }
+
+    auto vector_server = VectorServer::get_singleton();
+    auto canvas = vector_server->get_canvas();
+
+    float dpi_scale = RenderServer::get_singleton()->window_builder_->get_dpi_scaling_factor(get_window_index());
+
+    canvas->save_state();
+    canvas->set_transform(Transform2::from_scale(Vec2F(dpi_scale)) * vector_server->global_transform_offset *
+                          Transform2::from_translation(get_global_position()) * group_transform);
+    canvas->draw_raw_sub_texture(
+        textures[front_texture], RectF({}, texture_size.to_f32()), RectF({}, size), opacity);
+    canvas->restore_state();
+}
+
+void CanvasGroup::render_children() {
+    auto vector_server = VectorServer::get_singleton();
+
+    auto global_pos = get_global_position();
+
+    auto previous_transform_offset = vector_server->global_transform_offset;
+
+    vector_server->push_scene(scene);
+
+    // Draw the children relative to the group, so that moving the group doesn't change the recording.
+    vector_server->global_transform_offset = Transform2::from_translation(-global_pos);
+
+    // The whole group is recorded even if it's partly clipped, so the texture can be reused when it's revealed.
+    vector_server->push_clip_rect(RectF(global_pos, global_pos + size), false);
+
+    for (auto &child : get_all_children()) {
+        if (typeid(*child) == typeid(SubWindow)) {
+            continue;
+        }
+        draw_subtree(child.get());
+    }
+
+    vector_server->pop_clip_rect();
+
+    vector_server->global_transform_offset = previous_transform_offset;
+
+    vector_server->pop_scene();
+
+    auto new_scene_hash = scene->compute_hash();
+
+    bool changed = dirty || new_scene_hash != scene_hash || !textures[front_texture];
+
+    dirty = false;
+
+    if (!changed) {
+        return;
+    }
+
+    uint32_t back_texture = 1 - front_texture;
+
+    if (!textures[back_texture]) {
+        textures[back_texture] = RenderServer::get_singleton()->device_->create_texture(
+            {texture_size, Pathfinder::TextureFormat::Rgba8Unorm}, "CanvasGroup texture");
+    }
+
+    vector_server->render_scene_to_texture(scene, textures[back_texture]);
+
+    front_texture = back_texture;
+    scene_hash = new_scene_hash;
+}
+
+} // namespace revector
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "container.h"
+
+namespace revector {
+
+/**
+ * Renders its children into a cached texture, which is composited with an opacity and a transform each frame.
+ * The texture is re-rendered only when a redraw is queued in the subtree (see Node::queue_redraw()),
+ * so a complex but mostly static subtree (e.g. a toolbar or an SVG-heavy sidebar) costs a single textured quad
+ * per frame, without drawing the children on the CPU.
+ */
+class CanvasGroup : public Container {
+public:
+    CanvasGroup();
+
+    void pre_draw_children() override;
+
+    void post_draw_children() override;
+
+    bool draws_children_itself() const override {
+        return true;
+    }
+
+    void set_opacity(float new_opacity);
+
+    float get_opacity() const;
+
+    /// Transform of the composited texture, relative to the top-left corner of the group.
+    /// It's visual only, input is still handled at the untransformed positions.
+    void set_group_transform(const Transform2 &new_transform);
+
+    Transform2 get_group_transform() const;
+
+    /// Re-render the children on the next draw.
+    void invalidate();
+
+    /// Record the children every frame and re-render them if the recording differs from the cached one.
+    /// This catches changes that don't queue a redraw (e.g. custom drawing), at the cost of recording
+    /// the children each frame. Disabled by default.
+    void set_auto_invalidate(bool enabled);
+
+    bool get_auto_invalidate() const;
+
+private:
+    void render_children();
+
+    float opacity = 1;
+
+    Transform2 group_transform;
+
+    bool auto_invalidate = false;
+
+    bool dirty = true;
+
+    /// The texture being displayed is never rendered into. Instead, the other one is rendered and swapped in,
+    /// so that an enclosing cache (e.g. a ScrollContainer tile) sees a different texture and re-renders too.
+    std::array<std::shared_ptr<Pathfinder::Texture>, 2> textures;
+    uint32_t front_texture = 0;
+
+    Vec2I texture_size;
+
+    /// Recording of the children.
+    std::shared_ptr<Pathfinder::Scene> scene;
+    uint64_t scene_hash = 0;
+
+    struct {
+        bool skipped = false;
+    } temp_draw_data;
+};
+
+} // namespace revector
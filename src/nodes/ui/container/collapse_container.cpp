@@ -27,7 +27,7 @@ CollapseContainer::CollapseContainer() {
     collapse_button_->set_text("Collapsing Container");
     collapse_button_->set_flat(true);
     collapse_button_->set_toggle_mode(true);
-    collapse_button_->connect_signal("toggled", [this](bool p_pressed) { set_collapse(p_pressed); });
+    collapse_button_->toggled_signal.connect([this](bool p_pressed) { set_collapse(p_pressed); });
 
     add_embedded_child(collapse_button_);
 
@@ -66,6 +66,8 @@ void CollapseContainer::set_collapse(bool collapse) {
     }
     collapsed_ = collapse;
 
+    queue_redraw();
+
     if (!collapse) {
         this->size = this->size_before_collapse_;
     }
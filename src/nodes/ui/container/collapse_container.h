@@ -30,6 +30,7 @@ public:
         if (theme_panel_.has_value()) {
             theme_panel_->border_color = color;
         }
+        queue_redraw();
     }
 
     void set_collapse(bool collapse);
@@ -1,9 +1,14 @@
 #include "scroll_container.h"
 
+#include "../../scene_tree.h"
+
 using Pathfinder::clamp;
 
 namespace revector {
 
+/// Tiles beyond this number are evicted, least recently used first.
+constexpr size_t MAX_CACHED_CONTENT_TILES = 8;
+
 ScrollContainer::ScrollContainer() {
     type = NodeType::ScrollContainer;
 
@@ -98,12 +103,22 @@ void ScrollContainer::input(InputEvent &event) {
 void ScrollContainer::update(double dt) {
     NodeUi::update(dt);
 
-    adjust_layout();
-
     if (children.empty() || !children.front()->is_ui_node()) {
+        adjust_layout();
         return;
     }
 
+    // Scrolling doesn't change the layout, so it's only redone when the sizes change.
+    auto content_min_size = get_max_child_min_size();
+    if (size != laid_out_size || content_min_size != laid_out_content_size ||
+        children.front().get() != laid_out_content) {
+        adjust_layout();
+
+        laid_out_size = size;
+        laid_out_content_size = content_min_size;
+        laid_out_content = children.front().get();
+    }
+
     vscroll = std::max(0.0f, vscroll);
     hscroll = std::max(0.0f, hscroll);
 
@@ -124,7 +139,13 @@ void ScrollContainer::update(double dt) {
     // Scroll container can only have one effective control child.
     auto content = (NodeUi *)children.front().get();
 
-    content->set_position({-hscroll, -vscroll});
+    float dpi_scale = RenderServer::get_singleton()->window_builder_->get_dpi_scaling_factor(get_window_index());
+
+    content->set_position(-get_snapped_scroll(dpi_scale));
+}
+
+Vec2F ScrollContainer::get_snapped_scroll(float dpi_scale) const {
+    return Vec2F(std::round(hscroll * dpi_scale), std::round(vscroll * dpi_scale)) / dpi_scale;
 }
 
 void ScrollContainer::draw_scroll_bar() {
@@ -206,16 +227,44 @@ void ScrollContainer::set_size(Vec2F new_size) {
     size = new_size;
 }
 
+void ScrollContainer::set_content_caching(bool enabled) {
+    content_caching = enabled;
+
+    if (!content_caching) {
+        clear_content_tiles();
+    }
+}
+
+bool ScrollContainer::get_content_caching() const {
+    return content_caching;
+}
+
+bool ScrollContainer::draws_children_itself() const {
+    return temp_draw_data.cached;
+}
+
 void ScrollContainer::pre_draw_children() {
-    if (!visible_) {
+    // A zero-sized render target is not allowed.
+    temp_draw_data.skipped = !visible_ || get_size().is_any_zero();
+    temp_draw_data.cached = false;
+    if (temp_draw_data.skipped) {
         return;
     }
 
-    if (get_size().is_any_zero()) {
-        visible_ = false;
+    // Inside another recording, changes of our tiles would be invisible to the outer cache,
+    // so fall back to a render target.
+    temp_draw_data.cached = content_caching && !VectorServer::get_singleton()->is_recording() && !children.empty() &&
+                            children.front()->is_ui_node();
+
+    if (temp_draw_data.cached) {
+        VectorServer::get_singleton()->set_render_layer(render_layer);
+        draw_content_tiles();
         return;
     }
 
+    // Redraw marks of the content are consumed by the outer cache, so the tiles can't be trusted anymore.
+    clear_content_tiles();
+
     auto global_pos = get_global_position();
     float dpi_scale = RenderServer::get_singleton()->window_builder_->get_dpi_scaling_factor(get_window_index());
     auto size = get_size() * dpi_scale;
@@ -233,10 +282,13 @@ void ScrollContainer::pre_draw_children() {
 
     // For the temporary render target, we need to offset all child nodes back to the origin.
     vector_server->global_transform_offset = Transform2::from_translation(-global_pos);
+
+    // Children scrolled out of the viewport are culled.
+    vector_server->push_clip_rect(RectF(global_pos, global_pos + get_size()));
 }
 
 void ScrollContainer::post_draw_children() {
-    if (!visible_) {
+    if (temp_draw_data.skipped) {
         return;
     }
 
@@ -245,8 +297,16 @@ void ScrollContainer::post_draw_children() {
 
     auto vector_server = VectorServer::get_singleton();
 
+    if (temp_draw_data.cached) {
+        draw_scroll_bar();
+        vector_server->set_render_layer(0);
+        return;
+    }
+
     auto canvas = vector_server->get_canvas();
 
+    vector_server->pop_clip_rect();
+
     draw_scroll_bar();
 
     vector_server->global_transform_offset = Transform2();
@@ -262,4 +322,129 @@ void ScrollContainer::post_draw_children() {
     vector_server->set_render_layer(0);
 }
 
+void ScrollContainer::draw_content_tiles() {
+    auto vector_server = VectorServer::get_singleton();
+    auto canvas = vector_server->get_canvas();
+
+    float dpi_scale = RenderServer::get_singleton()->window_builder_->get_dpi_scaling_factor(get_window_index());
+
+    auto viewport_size = (size * dpi_scale).ceil();
+
+    if (viewport_size != tile_size) {
+        clear_content_tiles();
+        tile_size = viewport_size;
+        tile_scene = std::make_shared<Pathfinder::Scene>(0, RectF({}, tile_size.to_f32()));
+    }
+
+    draw_frame++;
+
+    // Scroll container can only have one effective control child.
+    auto content = (NodeUi *)children.front().get();
+    auto content_pos = content->get_global_position();
+
+    // Scrolling only moves the content, which doesn't queue a redraw in it.
+    bool content_changed = content->is_redraw_queued();
+    if (content_changed) {
+        for (auto &[coords, tile] : content_tiles) {
+            tile.stale = true;
+        }
+    }
+
+    auto global_pos = get_global_position();
+    auto viewport_rect = RectF(global_pos, global_pos + size);
+
+    // Tiles are laid out in the content's physical pixels.
+    auto tile_size_f = tile_size.to_f32();
+    auto scroll = get_snapped_scroll(dpi_scale) * dpi_scale;
+    auto first_tile = (scroll / tile_size_f).floor();
+    auto last_tile = ((scroll + viewport_size.to_f32() - Vec2F(1)) / tile_size_f).floor();
+
+    for (int32_t y = first_tile.y; y <= last_tile.y; y++) {
+        for (int32_t x = first_tile.x; x <= last_tile.x; x++) {
+            auto tile_origin = content_pos + Vec2F(x, y) * tile_size_f / dpi_scale;
+            auto tile_rect = RectF(tile_origin, tile_origin + tile_size_f / dpi_scale);
+
+            if (!tile_rect.intersects(viewport_rect)) {
+                continue;
+            }
+
+            update_content_tile(content, {x, y}, tile_origin, dpi_scale);
+
+            auto visible_rect = tile_rect.intersection(viewport_rect);
+            auto src_rect = RectF((visible_rect.origin() - tile_origin) * dpi_scale,
+                                  (visible_rect.lower_right() - tile_origin) * dpi_scale);
+
+            canvas->save_state();
+            canvas->set_transform(Transform2::from_scale(Vec2F(dpi_scale)) * vector_server->global_transform_offset);
+            canvas->draw_raw_sub_texture(content_tiles[{x, y}].texture, src_rect, visible_rect);
+            canvas->restore_state();
+        }
+    }
+
+    // After recording, as nested caches check their own marks while being drawn.
+    if (content_changed) {
+        content->consume_redraw();
+    }
+
+    // Evict the least recently used tiles.
+    while (content_tiles.size() > MAX_CACHED_CONTENT_TILES) {
+        auto oldest = content_tiles.begin();
+        for (auto iter = content_tiles.begin(); iter != content_tiles.end(); iter++) {
+            if (iter->second.last_used_frame < oldest->second.last_used_frame) {
+                oldest = iter;
+            }
+        }
+        content_tiles.erase(oldest);
+    }
+}
+
+void ScrollContainer::update_content_tile(NodeUi *content, Vec2I tile_coords, Vec2F tile_origin, float dpi_scale) {
+    auto vector_server = VectorServer::get_singleton();
+
+    auto &tile = content_tiles[{tile_coords.x, tile_coords.y}];
+    tile.last_used_frame = draw_frame;
+
+    if (tile.texture && !tile.stale) {
+        return;
+    }
+
+    tile.stale = false;
+
+    auto previous_transform_offset = vector_server->global_transform_offset;
+
+    vector_server->push_scene(tile_scene);
+
+    // Draw the content relative to the tile, so that the recording doesn't change when scrolling.
+    vector_server->global_transform_offset = Transform2::from_translation(-tile_origin);
+
+    // The whole tile is recorded, including the part outside the viewport, so it can be reused when scrolling.
+    vector_server->push_clip_rect(RectF(tile_origin, tile_origin + tile_size.to_f32() / dpi_scale), false);
+
+    draw_subtree(content);
+
+    vector_server->pop_clip_rect();
+
+    vector_server->global_transform_offset = previous_transform_offset;
+
+    vector_server->pop_scene();
+
+    // The content hasn't changed since the tile was rendered.
+    auto scene_hash = tile_scene->compute_hash();
+    if (tile.texture && tile.scene_hash == scene_hash) {
+        return;
+    }
+
+    if (!tile.texture) {
+        tile.texture = RenderServer::get_singleton()->device_->create_texture(
+            {tile_size, Pathfinder::TextureFormat::Rgba8Unorm}, "ScrollContainer content tile");
+    }
+
+    vector_server->render_scene_to_texture(tile_scene, tile.texture);
+    tile.scene_hash = scene_hash;
+}
+
+void ScrollContainer::clear_content_tiles() {
+    content_tiles.clear();
+}
+
 } // namespace revector
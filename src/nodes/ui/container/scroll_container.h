@@ -1,5 +1,7 @@
 #pragma once
 
+#include <map>
+
 #include "container.h"
 
 namespace revector {
@@ -17,6 +19,8 @@ public:
     void pre_draw_children() override;
     void post_draw_children() override;
 
+    bool draws_children_itself() const override;
+
     void adjust_layout() override;
 
     void calc_minimum_size() override;
@@ -35,6 +39,14 @@ public:
 
     void set_size(Vec2F new_size) override;
 
+    /// Keep the rendered content in viewport-sized tiles, so that scrolling only renders newly exposed tiles
+    /// and a static view doesn't render its content at all. Disabled by default.
+    /// Tiles are recorded again only when a redraw is queued in the content, so only enable this if the content
+    /// follows the contract of Node::queue_redraw(). Otherwise, the content is drawn stale.
+    void set_content_caching(bool enabled);
+
+    bool get_content_caching() const;
+
 protected:
     bool hscroll_enabled = true;
     bool vscroll_enabled = true;
@@ -50,7 +62,46 @@ protected:
 
     struct {
         Pathfinder::RenderTargetId render_target_id{};
+        bool skipped = false;
+        bool cached = false;
     } temp_draw_data;
+
+private:
+    /// Scroll offset snapped to physical pixels, so that cached tiles are composited without resampling.
+    Vec2F get_snapped_scroll(float dpi_scale) const;
+
+    /// Record the content overlapping a stale tile, and re-render it if the recording differs from the cached one.
+    void update_content_tile(NodeUi *content, Vec2I tile_coords, Vec2F tile_origin, float dpi_scale);
+
+    void draw_content_tiles();
+
+    void clear_content_tiles();
+
+    struct ContentTile {
+        std::shared_ptr<Pathfinder::Texture> texture;
+        uint64_t scene_hash = 0;
+        uint64_t last_used_frame = 0;
+
+        /// The content changed since the tile was recorded.
+        bool stale = false;
+    };
+
+    bool content_caching = false;
+
+    /// Tiles are as large as the viewport in physical pixels.
+    Vec2I tile_size;
+
+    std::map<std::pair<int32_t, int32_t>, ContentTile> content_tiles;
+
+    /// Recording of the tile being updated.
+    std::shared_ptr<Pathfinder::Scene> tile_scene;
+
+    uint64_t draw_frame = 0;
+
+    /// Size and content minimum size of the last layout, to skip redundant layouts.
+    Vec2F laid_out_size{-1};
+    Vec2F laid_out_content_size{-1};
+    Node *laid_out_content{};
 };
 
 } // namespace revector
@@ -53,6 +53,7 @@ void TabContainer::calc_minimum_size() {
     // Find the largest child size.
     for (auto &child : children) {
         // We should take account of invisible UI nodes.
+        // Hidden pages are not processed, so their last calculated minimum sizes are used.
         if (!child->is_ui_node()) {
             continue;
         }
@@ -101,6 +102,13 @@ void TabContainer::add_child(const std::shared_ptr<Node> &new_child) {
     }
 }
 
+void TabContainer::add_children(gsl::span<const std::shared_ptr<Node>> new_children) {
+    // Every child needs a tab button.
+    for (auto &new_child : new_children) {
+        add_child(new_child);
+    }
+}
+
 void TabContainer::add_tab_button() {
     auto button = std::make_shared<Button>();
     button_container->add_child(button);
@@ -112,8 +120,7 @@ void TabContainer::add_tab_button() {
 
     tab_button_group.add_button(button);
 
-    auto callback = [this, button_idx] { current_tab = button_idx; };
-    button->connect_signal("pressed", callback);
+    button->pressed_signal.connect([this, button_idx] { current_tab = button_idx; });
     button->set_toggle_mode(true);
 
     button->theme_normal.border_width = 0;
@@ -29,6 +29,8 @@ public:
 
     void add_child(const std::shared_ptr<Node>& new_child) override;
 
+    void add_children(gsl::span<const std::shared_ptr<Node>> new_children) override;
+
 protected:
     void add_tab_button();
 
@@ -0,0 +1,319 @@
+#include "virtual_list_container.h"
+
+#include "scroll_container.h"
+
+namespace revector {
+
+VirtualListContainer::VirtualListContainer() {
+    type = NodeType::VirtualListContainer;
+}
+
+void VirtualListContainer::calc_minimum_size() {
+    update_active_rows();
+
+    measure_active_rows();
+
+    float width = max_column_width * (float)column_count + separation * (float)(column_count - 1);
+
+    calculated_minimum_size = {width, get_content_height()};
+}
+
+void VirtualListContainer::adjust_layout() {
+    size = size.max(get_effective_minimum_size());
+
+    float column_width = (size.x - separation * (float)(column_count - 1)) / (float)column_count;
+
+    for (uint32_t i = 0; i < active_rows.size(); i++) {
+        auto &row = active_rows[i];
+        if (row == nullptr) {
+            continue;
+        }
+
+        uint32_t item_index = first_item + i;
+        uint32_t row_index = item_index / column_count;
+        uint32_t column_index = item_index % column_count;
+
+        float offset_y = get_row_offset(row_index);
+        float height = get_row_offset(row_index + 1) - offset_y - separation;
+
+        row->set_position({(float)column_index * (column_width + separation), offset_y});
+        row->set_size({column_width, height});
+    }
+}
+
+void VirtualListContainer::set_row_builder(RowBuilder new_builder) {
+    row_builder = std::move(new_builder);
+    needs_rebind = true;
+}
+
+void VirtualListContainer::set_item_count(uint32_t new_count) {
+    if (new_count < item_count) {
+        item_count = new_count;
+        reset_row_heights();
+        needs_rebind = true;
+        return;
+    }
+
+    // Appending keeps the bound rows and the measured heights of the existing items.
+    item_count = new_count;
+
+    if (!has_fixed_row_height()) {
+        while (row_heights.size() < get_row_count()) {
+            row_heights.push_back(estimated_row_height + separation);
+        }
+    }
+}
+
+uint32_t VirtualListContainer::get_item_count() const {
+    return item_count;
+}
+
+void VirtualListContainer::refresh_items() {
+    reset_row_heights();
+    needs_rebind = true;
+}
+
+void VirtualListContainer::set_column_count(uint32_t new_count) {
+    column_count = std::max(new_count, 1u);
+    reset_row_heights();
+    needs_rebind = true;
+}
+
+uint32_t VirtualListContainer::get_column_count() const {
+    return column_count;
+}
+
+void VirtualListContainer::set_row_height(float new_height) {
+    row_height = new_height;
+    reset_row_heights();
+}
+
+float VirtualListContainer::get_row_height() const {
+    return row_height;
+}
+
+void VirtualListContainer::set_estimated_row_height(float new_height) {
+    estimated_row_height = new_height;
+    reset_row_heights();
+}
+
+void VirtualListContainer::set_separation(float new_separation) {
+    separation = new_separation;
+    reset_row_heights();
+}
+
+void VirtualListContainer::set_overscan_rows(uint32_t new_count) {
+    overscan_rows = new_count;
+}
+
+std::shared_ptr<NodeUi> VirtualListContainer::get_item_widget(uint32_t item_index) const {
+    if (item_index < first_item || item_index >= first_item + active_rows.size()) {
+        return nullptr;
+    }
+    return active_rows[item_index - first_item];
+}
+
+void VirtualListContainer::scroll_to_item(uint32_t item_index) {
+    for (auto node = parent; node; node = node->get_parent()) {
+        if (node->get_node_type() != NodeType::ScrollContainer) {
+            continue;
+        }
+
+        auto scroll_container = dynamic_cast<ScrollContainer *>(node);
+
+        // Offset of the list in the scroll content.
+        float content_offset_y =
+            get_global_position().y - scroll_container->get_global_position().y + scroll_container->get_vscroll();
+
+        scroll_container->set_vscroll(content_offset_y + get_row_offset(item_index / column_count));
+        return;
+    }
+}
+
+uint32_t VirtualListContainer::get_row_count() const {
+    return (item_count + column_count - 1) / column_count;
+}
+
+bool VirtualListContainer::has_fixed_row_height() const {
+    return row_height > 0;
+}
+
+float VirtualListContainer::get_row_offset(uint32_t row) const {
+    if (has_fixed_row_height()) {
+        return (float)row * (row_height + separation);
+    }
+    return row_heights.prefix_sum(std::min<size_t>(row, row_heights.size()));
+}
+
+float VirtualListContainer::get_content_height() const {
+    uint32_t row_count = get_row_count();
+    if (row_count == 0) {
+        return 0;
+    }
+    return get_row_offset(row_count) - separation;
+}
+
+std::pair<uint32_t, uint32_t> VirtualListContainer::get_visible_row_range() const {
+    auto visible_rect = get_visible_rect();
+
+    if (!visible_rect.has_value()) {
+        return {0, 0};
+    }
+
+    auto global_position = get_global_position();
+
+    float top = visible_rect->top - global_position.y;
+    float bottom = visible_rect->bottom - global_position.y;
+
+    auto row_count = (float)get_row_count();
+
+    float first, last;
+
+    if (has_fixed_row_height()) {
+        float pitch = row_height + separation;
+        first = std::floor(top / pitch);
+        last = std::ceil(bottom / pitch);
+    } else {
+        first = (float)row_heights.find(top);
+        last = (float)row_heights.find(bottom) + 1;
+    }
+
+    first = std::clamp(first - (float)overscan_rows, 0.0f, row_count);
+    last = std::clamp(last + (float)overscan_rows, first, row_count);
+
+    return {(uint32_t)first, (uint32_t)last};
+}
+
+void VirtualListContainer::update_active_rows() {
+    auto [first_row, last_row] = get_visible_row_range();
+
+    uint32_t new_first_item = first_row * column_count;
+    uint32_t new_last_item = std::max(std::min(last_row * column_count, item_count), new_first_item);
+
+    if (!row_builder) {
+        new_last_item = new_first_item;
+    }
+
+    bool children_changed = needs_rebind;
+
+    std::vector<std::shared_ptr<NodeUi>> new_active_rows(new_last_item - new_first_item);
+
+    // Keep the rows of items that are still visible, recycle the rest.
+    for (uint32_t i = 0; i < active_rows.size(); i++) {
+        auto &row = active_rows[i];
+        if (row == nullptr) {
+            continue;
+        }
+
+        uint32_t item_index = first_item + i;
+
+        if (!needs_rebind && item_index >= new_first_item && item_index < new_last_item) {
+            new_active_rows[item_index - new_first_item] = std::move(row);
+        } else {
+            recycled_rows.push_back(std::move(row));
+            children_changed = true;
+        }
+    }
+
+    needs_rebind = false;
+
+    std::vector<std::shared_ptr<NodeUi>> new_rows;
+
+    for (uint32_t i = 0; i < new_active_rows.size(); i++) {
+        auto &row = new_active_rows[i];
+        if (row) {
+            continue;
+        }
+
+        std::shared_ptr<NodeUi> recycled_row;
+        if (!recycled_rows.empty()) {
+            recycled_row = std::move(recycled_rows.back());
+            recycled_rows.pop_back();
+        }
+
+        row = row_builder(new_first_item + i, recycled_row);
+
+        // The builder chose not to reuse the recycled row.
+        if (recycled_row && row != recycled_row) {
+            recycled_rows.push_back(std::move(recycled_row));
+        }
+
+        if (row) {
+            new_rows.push_back(row);
+        }
+        children_changed = true;
+    }
+
+    active_rows = std::move(new_active_rows);
+    first_item = new_first_item;
+
+    if (!children_changed) {
+        return;
+    }
+
+    remove_all_children();
+
+    std::vector<std::shared_ptr<Node>> rows;
+    rows.reserve(active_rows.size());
+    for (auto &row : active_rows) {
+        if (row) {
+            rows.push_back(row);
+        }
+    }
+    add_children(rows);
+
+    // Newly bound rows missed the ready and minimum size passes of this frame.
+    for (auto &row : new_rows) {
+        std::vector<Node *> nodes;
+        dfs_preorder_ltr_traversal(row.get(), nodes);
+        for (auto &node : nodes) {
+            node->ready();
+        }
+
+        row->calc_minimum_size_recursively();
+    }
+}
+
+void VirtualListContainer::measure_active_rows() {
+    for (auto &row : active_rows) {
+        if (row) {
+            max_column_width = std::max(max_column_width, row->get_effective_minimum_size().x);
+        }
+    }
+
+    if (has_fixed_row_height()) {
+        return;
+    }
+
+    // A row is as high as its highest item.
+    for (uint32_t i = 0; i < active_rows.size(); i += column_count) {
+        uint32_t row_index = (first_item + i) / column_count;
+        if (row_index >= row_heights.size()) {
+            break;
+        }
+
+        float height = 0;
+        for (uint32_t j = i; j < std::min<size_t>(i + column_count, active_rows.size()); j++) {
+            if (active_rows[j]) {
+                height = std::max(height, active_rows[j]->get_effective_minimum_size().y);
+            }
+        }
+
+        float cached_height = get_row_offset(row_index + 1) - get_row_offset(row_index);
+        float delta = height + separation - cached_height;
+
+        if (std::abs(delta) > 0.01f) {
+            row_heights.add(row_index, delta);
+        }
+    }
+}
+
+void VirtualListContainer::reset_row_heights() {
+    if (has_fixed_row_height()) {
+        row_heights.clear();
+    } else {
+        row_heights.assign(get_row_count(), estimated_row_height + separation);
+    }
+}
+
+} // namespace revector
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "../../../common/fenwick_tree.h"
+#include "../../../common/signal.h"
+#include "container.h"
+
+namespace revector {
+
+/**
+ * A list (or grid) that only creates widgets for the items inside the visible area.
+ * Rows that are scrolled out of view are recycled for the newly exposed items.
+ * Put it inside a ScrollContainer.
+ */
+class VirtualListContainer : public Container {
+public:
+    /// Creates or rebinds the row widget for an item.
+    /// `recycled_row` is a row previously built for another item (null if none is available),
+    /// which should be updated and returned instead of creating a new one.
+    using RowBuilder = Callable<std::shared_ptr<NodeUi>(uint32_t item_index, std::shared_ptr<NodeUi> recycled_row)>;
+
+    VirtualListContainer();
+
+    /// Rows are bound here, so that newly bound rows take part in the transform and update passes of the same frame.
+    void calc_minimum_size() override;
+
+    void adjust_layout() override;
+
+    void set_row_builder(RowBuilder new_builder);
+
+    /// Growing the count appends items, keeping the bound rows and measured heights.
+    /// Shrinking it rebinds all rows and drops the measured heights.
+    void set_item_count(uint32_t new_count);
+
+    uint32_t get_item_count() const;
+
+    /// Rebind all visible rows, e.g. after the item data has changed.
+    void refresh_items();
+
+    /// Items per row. Values greater than 1 make a grid.
+    void set_column_count(uint32_t new_count);
+
+    uint32_t get_column_count() const;
+
+    /// Use a fixed height for all rows. A non-positive value enables variable heights,
+    /// which are measured when rows become visible and cached afterwards.
+    void set_row_height(float new_height);
+
+    float get_row_height() const;
+
+    /// Height assumed for rows not measured yet, when using variable heights.
+    void set_estimated_row_height(float new_height);
+
+    void set_separation(float new_separation);
+
+    /// Extra rows bound above and below the visible ones.
+    void set_overscan_rows(uint32_t new_count);
+
+    /// Get the widget currently bound to an item. Returns null if the item is not visible.
+    std::shared_ptr<NodeUi> get_item_widget(uint32_t item_index) const;
+
+    /// Scroll the enclosing ScrollContainer so that the item's row is at the top.
+    void scroll_to_item(uint32_t item_index);
+
+private:
+    uint32_t get_row_count() const;
+
+    bool has_fixed_row_height() const;
+
+    /// Offset of a row from the top, including separations.
+    float get_row_offset(uint32_t row) const;
+
+    float get_content_height() const;
+
+    /// Rows within the window and all ancestor scroll containers, with overscan.
+    std::pair<uint32_t, uint32_t> get_visible_row_range() const;
+
+    /// Recycle rows leaving the visible range and build rows for the newly exposed items.
+    void update_active_rows();
+
+    /// Cache the measured heights of the active rows.
+    void measure_active_rows();
+
+    /// Reset cached heights after the row layout or the item data has changed.
+    void reset_row_heights();
+
+    RowBuilder row_builder;
+
+    uint32_t item_count = 0;
+
+    uint32_t column_count = 1;
+
+    float row_height = 32;
+
+    float estimated_row_height = 32;
+
+    float separation = 0;
+
+    uint32_t overscan_rows = 2;
+
+    /// Row heights plus separation. Only used for variable heights.
+    FenwickTree<float> row_heights;
+
+    /// Widgets of the items in [first_item, first_item + active_rows.size()).
+    std::vector<std::shared_ptr<NodeUi>> active_rows;
+    uint32_t first_item = 0;
+
+    /// Widgets of items out of view, ready to be rebound.
+    std::vector<std::shared_ptr<NodeUi>> recycled_rows;
+
+    /// Widest column seen so far. Items are not measured until they are visible.
+    float max_column_width = 0;
+
+    bool needs_rebind = false;
+};
+
+} // namespace revector
@@ -15,7 +15,7 @@ enum class Bidi {
     RightToLeft,
 };
 
-std::vector<Pathfinder::Range> get_line_breakable_groups(const std::vector<LayoutGlyph> &glyphs, int offset) {
+std::vector<Pathfinder::Range> get_line_breakable_groups(const GlyphRun &glyphs, const Pathfinder::Range &para_range) {
     std::vector<Pathfinder::Range> groups;
 
     bool rtl = false;
@@ -40,19 +40,17 @@ std::vector<Pathfinder::Range> get_line_breakable_groups(const std::vector<Layou
         //            r.begin = r.begin + 1 - r.length;
         //        }
     } else {
-        uint32_t group_start = 0;
+        uint32_t group_start = para_range.start;
 
-        for (int g_idx = 0; g_idx < glyphs.size(); g_idx++) {
-            auto &g = glyphs[g_idx];
-
-            if (g.line_breakable_ && g_idx != 0) {
-                Pathfinder::Range group = {offset + group_start, offset + static_cast<unsigned long long>(g_idx)};
+        for (uint32_t g_idx = para_range.start; g_idx < para_range.end; g_idx++) {
+            if (glyphs.has_flag(g_idx, GLYPH_FLAG_LINE_BREAKABLE) && g_idx != para_range.start) {
+                Pathfinder::Range group = {group_start, g_idx};
                 group_start = g_idx;
                 groups.push_back(group);
             }
         }
 
-        Pathfinder::Range group = {offset + group_start, offset + (uint32_t)glyphs.size()};
+        Pathfinder::Range group = {group_start, para_range.end};
         groups.push_back(group);
     }
 
@@ -62,7 +60,7 @@ std::vector<Pathfinder::Range> get_line_breakable_groups(const std::vector<Layou
 /// PARAs -> LINEs
 std::vector<Line> get_lines_with_word_wrap(float limited_width,
                                            const std::vector<Line> &original_paras,
-                                           const std::vector<LayoutGlyph> &glyphs,
+                                           const GlyphRun &glyphs,
                                            Vec2F &out_text_size) {
     float tracking = 0;
 
@@ -73,14 +71,8 @@ std::vector<Line> get_lines_with_word_wrap(float limited_width,
     for (const auto &para : original_paras) {
         const auto &para_range = para.glyph_ranges;
 
-        // Get glyphs in this paragraph.
-        std::vector<LayoutGlyph> para_glyphs;
-        for (int glyph_idx = para_range.start; glyph_idx < para_range.end; glyph_idx++) {
-            para_glyphs.push_back(glyphs[glyph_idx]);
-        }
-
         // Get line-breakable groups in this paragraph.
-        auto groups_in_para = get_line_breakable_groups(para_glyphs, para_range.start);
+        auto groups_in_para = get_line_breakable_groups(glyphs, para_range);
 
         std::vector<float> group_widths_in_para;
 
@@ -99,8 +91,7 @@ std::vector<Line> get_lines_with_word_wrap(float limited_width,
                  para.rtl ? j-- : j++) {
                 int glyph_idx = p_group->start + j;
 
-                const Glyph &glyph = glyphs[glyph_idx].glyph_;
-                float glyph_width = glyph.x_advance;
+                float glyph_width = glyphs.advances[glyph_idx];
 
                 // Handle some abonormal graphs which are too wide.
                 if (group_width == 0 && glyph_width > limited_width) {
@@ -287,69 +278,59 @@ void Label::set_size(Vec2F new_size) {
 }
 
 /// A very crude way for line-breaking.
-std::vector<LayoutGlyph> convert_to_in_context_glyphs(const std::vector<Glyph> &glyphs,
-                                                      const std::vector<Line> &paragraphs) {
-    std::vector<LayoutGlyph> in_context_glyphs;
-    in_context_glyphs.resize(glyphs.size());
-
+void mark_line_breakable_glyphs(GlyphRun &glyphs, const std::vector<Line> &paragraphs) {
     // Add line-breaking info.
     for (auto &para : paragraphs)
         for (int glyph_idx = para.glyph_ranges.start; glyph_idx < para.glyph_ranges.end; glyph_idx++) {
-            const auto &glyph = glyphs[glyph_idx];
-
-            LayoutGlyph in_context_glyph;
-            in_context_glyph.glyph_ = glyph;
-            in_context_glyph.line_breakable_ = false;
+            bool line_breakable = false;
 
-            if (glyph.script == Script::Cjk) {
-                in_context_glyph.line_breakable_ = true;
+            if (glyphs.has_flag(glyph_idx, GLYPH_FLAG_CJK)) {
+                line_breakable = true;
             } else {
                 if (para.rtl) {
                     if (glyph_idx < para.glyph_ranges.end - 1) {
-                        auto &previous_glyph = glyphs[glyph_idx + 1];
-                        if (previous_glyph.text == " ") {
-                            in_context_glyph.line_breakable_ = true;
-                        }
+                        line_breakable = glyphs.has_flag(glyph_idx + 1, GLYPH_FLAG_SPACE);
                     }
                 } else {
                     if (glyph_idx > para.glyph_ranges.start) {
-                        auto &previous_glyph = glyphs[glyph_idx - 1];
-                        if (previous_glyph.text == " ") {
-                            in_context_glyph.line_breakable_ = true;
-                        }
+                        line_breakable = glyphs.has_flag(glyph_idx - 1, GLYPH_FLAG_SPACE);
                     }
                 }
             }
 
-            in_context_glyphs[glyph_idx] = in_context_glyph;
+            if (line_breakable) {
+                glyphs.flags[glyph_idx] |= GLYPH_FLAG_LINE_BREAKABLE;
+            }
         }
-
-    return in_context_glyphs;
 }
 
 void Label::measure() {
     font->get_glyphs(text_, font_size_, glyphs_, paragraphs_);
 
-    // Add emoji data.
+    // Draw missing glyphs from the emoji font if it has them.
     if (emoji_font && emoji_font->is_valid()) {
-        for (auto &glyph : glyphs_) {
-            if (glyph.codepoints.size() == 1 && glyph.index == 0) {
-                uint16_t glyph_index = emoji_font->find_glyph_index_by_codepoint(glyph.codepoints.front());
-                if (glyph_index == 0) {
-                    continue;
-                }
-                glyph.emoji = true;
+        for (size_t i = 0; i < glyphs_.size(); i++) {
+            if (glyphs_.cluster_lengths[i] != 1 || glyphs_.indices[i] != 0) {
+                continue;
+            }
 
-                glyph.svg = emoji_font->get_glyph_svg(glyph_index);
-                if (!glyph.svg.empty() && glyph.index == 0) {
-                    glyph.x_advance = font_size_;
-                    glyph.box = {0, 0, (float)font_size_, (float)font_size_};
-                }
+            uint16_t glyph_index = emoji_font->find_glyph_index_by_codepoint(text_u32_[glyphs_.cluster_starts[i]]);
+            if (glyph_index == 0 || emoji_font->get_glyph_svg(glyph_index).empty()) {
+                continue;
             }
+
+            // Keep the baseline of the text.
+            auto face = glyphs_.get_face(i);
+            face.font = emoji_font;
+
+            glyphs_.indices[i] = glyph_index;
+            glyphs_.face_indices[i] = glyphs_.add_face(face);
+            glyphs_.flags[i] |= GLYPH_FLAG_EMOJI;
+            glyphs_.advances[i] = font_size_;
         }
     }
 
-    layout_glyphs_ = convert_to_in_context_glyphs(glyphs_, paragraphs_);
+    mark_line_breakable_glyphs(glyphs_, paragraphs_);
 }
 
 void Label::make_layout() {
@@ -368,7 +349,7 @@ void Label::make_layout() {
 
     if (word_wrap_) {
         Vec2F text_size{};
-        lines_ = get_lines_with_word_wrap(size.x, paragraphs_, layout_glyphs_, text_size);
+        lines_ = get_lines_with_word_wrap(size.x, paragraphs_, glyphs_, text_size);
     }
 
     const auto &effective_line_ranges = word_wrap_ ? lines_ : paragraphs_;
@@ -405,20 +386,21 @@ void Label::make_layout() {
         }
 
         for (int i = range.start; i < range.end; i++) {
-            const auto &g = glyphs_[i];
+            const auto &offset = glyphs_.offsets[i];
+            float advance = glyphs_.advances[i];
 
             // The glyph's layout box in the text's local coordinates.
             // The origin is the top-left corner of the text box.
             RectF glyph_layout_box =
-                RectF(cursor_x + g.x_offset, cursor_y + g.y_offset, cursor_x + g.x_advance, cursor_y + line_height);
+                RectF(cursor_x + offset.x, cursor_y + offset.y, cursor_x + advance, cursor_y + line_height);
 
-            glyph_positions[i] = {cursor_x + g.x_offset, cursor_y + g.y_offset};
+            glyph_positions[i] = {cursor_x + offset.x, cursor_y + offset.y};
 
             // The whole text's layout box.
             layout_box = layout_box.union_rect(glyph_layout_box);
 
             // Advance x.
-            cursor_x += g.x_advance;
+            cursor_x += advance;
         }
 
         cursor_x = 0;
@@ -478,6 +460,7 @@ void Label::update(double dt) {
     if (layout_is_dirty) {
         layout_is_dirty = false;
         make_layout();
+        queue_redraw();
     }
 
     auto min_size = get_text_minimum_size();
@@ -486,6 +469,17 @@ void Label::update(double dt) {
     consider_alignment();
 }
 
+void Label::hash_draw_state(Pathfinder::Hasher &hasher) const {
+    NodeUi::hash_draw_state(hasher);
+
+    hasher.write_u64(text_style.color.to_u32());
+    hasher.write_u64(text_style.stroke_color.to_u32());
+    hasher.write_f32(text_style.stroke_width);
+    hasher.write_u64(text_style.italic | text_style.bold << 1 | text_style.debug << 2);
+    hasher.write_u64(font_size_);
+    hasher.write_u64((uint64_t)horizontal_alignment | (uint64_t)vertical_alignment << 8);
+}
+
 void Label::set_text_style(TextStyle _text_style) {
     text_style = _text_style;
 }
@@ -558,7 +552,7 @@ Vec2F Label::get_text_minimum_size() const {
     return text_bbox;
 }
 
-std::vector<Glyph> &Label::get_glyphs() {
+const GlyphRun &Label::get_glyphs() const {
     return glyphs_;
 }
 
@@ -574,7 +568,7 @@ float Label::get_glyph_right_edge_position(int32_t glyph_index) {
     assert(glyph_index < glyphs_.size() && "Out of bounds glyph index!");
 
     for (int i = 0; i <= glyph_index; i++) {
-        pos += glyphs_[i].x_advance;
+        pos += glyphs_.advances[i];
     }
 
     return pos;
@@ -586,7 +580,7 @@ float Label::get_glyph_left_edge_position(int32_t glyph_index) {
     float pos = 0;
 
     for (int i = 0; i < glyph_index; i++) {
-        pos += glyphs_[i].x_advance;
+        pos += glyphs_.advances[i];
     }
 
     return pos;
@@ -601,20 +595,18 @@ float Label::get_codepoint_right_edge_position(int32_t codepoint_index) {
     int32_t glyph_group_size = 0;
 
     for (int i = 0; i < glyphs_.size(); i++) {
-        const auto &glyph = glyphs_[i];
+        int32_t cluster_start = glyphs_.cluster_starts[i];
 
-        if (codepoint_index >= glyph.start && codepoint_index < glyph.end) {
+        if (codepoint_index >= cluster_start && codepoint_index < glyphs_.get_cluster_end(i)) {
             glyph_group_start = i;
-            glyph_group_size = codepoint_index - glyph.start + 1;
+            glyph_group_size = codepoint_index - cluster_start + 1;
             break;
         }
     }
 
     for (int i = 0; i < glyphs_.size(); i++) {
-        const auto &glyph = glyphs_[i];
-
         if (i < (glyph_group_start + glyph_group_size)) {
-            pos += glyph.x_advance;
+            pos += glyphs_.advances[i];
         }
     }
 
@@ -26,11 +26,6 @@ enum class Alignment {
     End,
 };
 
-struct LayoutGlyph {
-    Glyph glyph_;
-    bool line_breakable_ = false;
-};
-
 class Label : public NodeUi {
 public:
     Label();
@@ -76,7 +71,7 @@ public:
 
     void calc_minimum_size() override;
 
-    std::vector<Glyph> &get_glyphs();
+    const GlyphRun &get_glyphs() const;
 
     std::shared_ptr<Font> get_font() const;
 
@@ -101,6 +96,9 @@ public:
 
     StyleBox theme_background;
 
+protected:
+    void hash_draw_state(Pathfinder::Hasher &hasher) const override;
+
 private:
     void measure();
 
@@ -130,10 +128,8 @@ private:
     /// If automatically break lines at suitable positions.
     bool word_wrap_ = false;
 
-    // Layout-independent. Glyph count will not necessarily be the same as the character count.
-    std::vector<Glyph> glyphs_;
-
-    std::vector<LayoutGlyph> layout_glyphs_;
+    // Layout-independent, aside from the line-breakable flags.
+    GlyphRun glyphs_;
 
     // Layout-dependent. Ranges for glyphs, not for characters.
     std::vector<Line> paragraphs_;
@@ -20,7 +20,7 @@ MenuButton::MenuButton() {
 
     menu->set_visibility(false);
 
-    pressed_callbacks.emplace_back([this] {
+    pressed_signal.connect([this] {
         if (menu->get_item_count() == 0) {
             return;
         }
@@ -31,19 +31,18 @@ MenuButton::MenuButton() {
         menu->set_visibility(true);
     });
 
-    auto callback = [this](uint32_t item_index) { when_item_selected(item_index); };
-    menu->connect_signal("item_selected", callback);
+    menu->item_selected_signal.connect([this](uint32_t item_index) { when_item_selected(item_index); });
 }
 
 std::weak_ptr<PopupMenu> MenuButton::get_popup_menu() const {
     return menu;
 }
 
-void MenuButton::connect_signal(const std::string& signal, const AnyCallable<void>& callback) {
+void MenuButton::connect_signal(SignalId signal, const AnyCallable<void>& callback) {
     Button::connect_signal(signal, callback);
 
-    if (signal == "item_selected") {
-        selected_callbacks.push_back(callback);
+    if (signal == SignalId::ItemSelected) {
+        item_selected_signal.connect(make_typed_slot<uint32_t>(callback));
     }
 }
 
@@ -66,13 +65,7 @@ void MenuButton::when_item_selected(uint32_t item_index) {
     set_text(menu->get_item_text(item_index));
     selected_item_index = item_index;
 
-    for (auto& callback : selected_callbacks) {
-        try {
-            callback.operator()<uint32_t>(std::move(item_index));
-        } catch (std::bad_any_cast&) {
-            Logger::error("Mismatched signal argument types!");
-        }
-    }
+    item_selected_signal.emit(item_index);
 }
 
 } // namespace revector
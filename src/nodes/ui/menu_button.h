@@ -13,7 +13,9 @@ public:
 
     std::weak_ptr<PopupMenu> get_popup_menu() const;
 
-    void connect_signal(const std::string &signal, const AnyCallable<void> &callback) override;
+    using Button::connect_signal;
+
+    void connect_signal(SignalId signal, const AnyCallable<void> &callback) override;
 
     /// Manually select an item.
     void select_item(uint32_t item_index);
@@ -22,13 +24,13 @@ public:
 
     std::string get_selected_item_text() const;
 
+    TypedSignal<uint32_t> item_selected_signal;
+
 protected:
     std::optional<uint32_t> selected_item_index;
 
     std::shared_ptr<PopupMenu> menu;
 
-    std::vector<AnyCallable<void>> selected_callbacks;
-
     void when_item_selected(uint32_t item_index);
 };
 
@@ -124,6 +124,35 @@ void NodeUi::calc_global_position(Vec2F parent_global_position) {
     calculated_global_position = parent_global_position + position;
 }
 
+void NodeUi::check_draw_state() {
+    if (position != checked_position) {
+        checked_position = position;
+
+        if (parent) {
+            parent->queue_redraw();
+        }
+    }
+
+    Pathfinder::Hasher hasher;
+    hash_draw_state(hasher);
+
+    auto draw_state = hasher.finish();
+    if (draw_state != checked_draw_state) {
+        checked_draw_state = draw_state;
+        queue_redraw();
+    }
+}
+
+void NodeUi::hash_draw_state(Pathfinder::Hasher &hasher) const {
+    hasher.write_f32(size.x);
+    hasher.write_f32(size.y);
+    hasher.write_u64(modulate.to_u32());
+    hasher.write_u64(self_modulate.to_u32());
+    hasher.write_f32(alpha);
+    hasher.write_u64(focused);
+    hasher.write_u64(is_cursor_inside);
+}
+
 void NodeUi::set_mouse_filter(MouseFilter filter) {
     mouse_filter = filter;
 }
@@ -165,13 +194,7 @@ void NodeUi::grab_focus() {
 }
 
 void NodeUi::release_focus() {
-    for (auto &callback : callbacks_focus_released) {
-        try {
-            callback();
-        } catch (std::bad_any_cast &) {
-            Logger::error("Mismatched signal argument types!");
-        }
-    }
+    focus_released_signal.emit();
 
     focused = false;
 }
@@ -187,6 +210,53 @@ ColorU NodeUi::get_global_modulate() {
 
 void NodeUi::set_theme_bg(StyleBox style_box) {
     theme_bg = std::make_optional(style_box);
+    queue_redraw();
+}
+
+std::optional<RectF> NodeUi::get_visible_rect() const {
+    auto window = RenderServer::get_singleton()->window_builder_->get_window(get_window_index());
+
+    auto visible_rect = RectF({}, window.lock()->get_logical_size().to_f32());
+
+    auto global_position = get_global_position();
+
+    std::vector<RectF> clip_rects = {RectF(global_position, global_position + size)};
+
+    // Scroll containers clip their content.
+    for (auto node = parent; node; node = node->get_parent()) {
+        if (node->get_node_type() == NodeType::ScrollContainer) {
+            auto ui_node = dynamic_cast<NodeUi *>(node);
+            auto position = ui_node->get_global_position();
+            clip_rects.emplace_back(position, position + ui_node->get_size());
+        }
+    }
+
+    for (auto &clip_rect : clip_rects) {
+        if (!visible_rect.intersects(clip_rect)) {
+            return {};
+        }
+        visible_rect = visible_rect.intersection(clip_rect);
+    }
+
+    return visible_rect;
+}
+
+void NodeUi::set_draw_culling(bool enabled) {
+    draw_culling = enabled;
+}
+
+bool NodeUi::get_draw_culling() const {
+    return draw_culling;
+}
+
+bool NodeUi::is_outside_clip_rect() const {
+    if (!draw_culling) {
+        return false;
+    }
+
+    auto global_position = get_global_position();
+
+    return !VectorServer::get_singleton()->is_rect_visible(RectF(global_position, global_position + size));
 }
 
 bool NodeUi::is_inside_container() const {
@@ -199,7 +269,9 @@ bool NodeUi::is_inside_container() const {
             case NodeType::HBoxContainer:
             case NodeType::VBoxContainer:
             case NodeType::ScrollContainer:
-            case NodeType::TabContainer: {
+            case NodeType::TabContainer:
+            case NodeType::VirtualListContainer:
+            case NodeType::CanvasGroup: {
                 return true;
             } break;
             default:
@@ -313,15 +385,11 @@ void NodeUi::apply_anchor() {
 }
 
 void NodeUi::cursor_entered() {
-    for (auto &callback : callbacks_cursor_entered) {
-        callback();
-    }
+    cursor_entered_signal.emit();
 }
 
 void NodeUi::cursor_exited() {
-    for (auto &callback : callbacks_cursor_exited) {
-        callback();
-    }
+    cursor_exited_signal.emit();
 }
 
 void NodeUi::set_anchor_flag(AnchorFlag anchor_flag) {
@@ -345,11 +413,21 @@ void NodeUi::when_parent_size_changed(Vec2F new_size) {
     }
 }
 
-void NodeUi::connect_signal(const std::string &signal, const AnyCallable<void> &callback) {
+void NodeUi::connect_signal(SignalId signal, const AnyCallable<void> &callback) {
     Node::connect_signal(signal, callback);
 
-    if (signal == "focus_released") {
-        callbacks_focus_released.push_back(callback);
+    switch (signal) {
+        case SignalId::CursorEntered: {
+            cursor_entered_signal.connect(make_typed_slot<>(callback));
+        } break;
+        case SignalId::CursorExited: {
+            cursor_exited_signal.connect(make_typed_slot<>(callback));
+        } break;
+        case SignalId::FocusReleased: {
+            focus_released_signal.connect(make_typed_slot<>(callback));
+        } break;
+        default:
+            break;
     }
 }
 
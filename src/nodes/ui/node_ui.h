@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <vector>
 
 #include "../../common/geometry.h"
@@ -97,6 +98,22 @@ public:
 
     void calc_global_position(Vec2F parent_global_position);
 
+    /// Part of the node rect (in global coordinates) not clipped by the window and ancestor scroll containers.
+    /// Returns nothing if the node is completely clipped.
+    std::optional<RectF> get_visible_rect() const;
+
+    /// Nodes drawing outside their rect should disable this, so that they are not culled by draw_system.
+    void set_draw_culling(bool enabled);
+
+    bool get_draw_culling() const;
+
+    /// Check if the node rect is outside the current clip rect of the vector server.
+    bool is_outside_clip_rect() const;
+
+    /// Queue a redraw if the drawing state changed since the last check. Called by the scene tree after update().
+    /// A moved node queues a redraw of its parent instead, as its own rendering stays the same.
+    void check_draw_state();
+
     virtual bool ignore_mouse_input_outside_rect() const {
         return false;
     }
@@ -141,10 +158,17 @@ public:
 
     void when_cursor_exited();
 
-    void connect_signal(const std::string &signal, const AnyCallable<void> &callback) override;
+    using Node::connect_signal;
+
+    void connect_signal(SignalId signal, const AnyCallable<void> &callback) override;
 
     void set_theme_bg(StyleBox style_box);
 
+    // Signals.
+    TypedSignal<> cursor_entered_signal;
+    TypedSignal<> cursor_exited_signal;
+    TypedSignal<> focus_released_signal;
+
 protected:
     Vec2F position{0};
     Vec2F size{1};
@@ -185,10 +209,15 @@ protected:
 
     MouseFilter mouse_filter = MouseFilter::Stop;
 
-    std::vector<AnyCallable<void>> callbacks_cursor_entered;
-    std::vector<AnyCallable<void>> callbacks_cursor_exited;
-    std::vector<AnyCallable<void>> callbacks_focus_released;
-    std::vector<AnyCallable<void>> callbacks_parent_size_changed;
+    bool draw_culling = true;
+
+    /// Feed the state draw() depends on into the hasher, except for the position.
+    /// Nodes drawing from their own state should extend it, so that cached renderings of ancestors are updated.
+    virtual void hash_draw_state(Pathfinder::Hasher &hasher) const;
+
+private:
+    Vec2F checked_position{0};
+    uint64_t checked_draw_state = 0;
 };
 
 } // namespace revector
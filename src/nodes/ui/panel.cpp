@@ -17,6 +17,7 @@ Panel::Panel() {
 
 void Panel::set_theme_panel(StyleBox style_box) {
     theme_panel_ = std::make_optional(style_box);
+    queue_redraw();
 }
 
 void Panel::draw() {
@@ -29,8 +29,7 @@ PopupMenu::PopupMenu() {
     vbox_container_ = std::make_shared<VBoxContainer>();
     margin_container_->add_child(vbox_container_);
 
-    auto callback = [this] { set_visibility(false); };
-    connect_signal("focus_released", callback);
+    focus_released_signal.connect([this] { set_visibility(false); });
 
     theme_bg_ = std::make_optional(panel);
 }
@@ -133,7 +132,7 @@ void PopupMenu::input(InputEvent &event) {
 }
 
 void PopupMenu::set_visibility(bool visible) {
-    visible_ = visible;
+    NodeUi::set_visibility(visible);
     if (visible_) {
         // TODO: we should not do this manually in here.
         margin_container_->calc_minimum_size_recursively();
@@ -163,7 +162,7 @@ void PopupMenu::calc_minimum_size() {
 }
 
 void PopupMenu::create_item(const std::string &text) {
-    auto new_item = std::make_shared<Button>();
+    auto new_item = make_node<Button>();
     new_item->set_text(text);
     new_item->theme_normal.bg_color = ColorU::transparent_black();
     new_item->theme_normal.border_width = 0;
@@ -172,11 +171,10 @@ void PopupMenu::create_item(const std::string &text) {
 
     int item_index = vbox_container_->get_children().size() - 1;
 
-    auto callback = [item_index, this] {
+    new_item->pressed_signal.connect([item_index, this] {
         set_visibility(false);
         when_item_selected(item_index);
-    };
-    new_item->connect_signal("pressed", callback);
+    });
 
     items_.push_back(new_item);
 }
@@ -198,35 +196,27 @@ std::string PopupMenu::get_item_text(uint32_t item_index) const {
     return items_[item_index]->get_text();
 }
 
-void PopupMenu::connect_signal(const std::string &signal, const AnyCallable<void> &callback) {
+void PopupMenu::connect_signal(SignalId signal, const AnyCallable<void> &callback) {
     NodeUi::connect_signal(signal, callback);
 
-    if (signal == "item_selected") {
-        item_selected_callbacks.push_back(callback);
-    }
-    if (signal == "popup_hide") {
-        popup_hide_callbacks.push_back(callback);
+    switch (signal) {
+        case SignalId::ItemSelected: {
+            item_selected_signal.connect(make_typed_slot<uint32_t>(callback));
+        } break;
+        case SignalId::PopupHide: {
+            popup_hide_signal.connect(make_typed_slot<>(callback));
+        } break;
+        default:
+            break;
     }
 }
 
 void PopupMenu::when_item_selected(uint32_t item_index) {
-    for (auto &callback : item_selected_callbacks) {
-        try {
-            callback.operator()<uint32_t>(std::move(item_index));
-        } catch (std::bad_any_cast &) {
-            Logger::error("Mismatched signal argument types!", "revector");
-        }
-    }
+    item_selected_signal.emit(item_index);
 }
 
 void PopupMenu::when_popup_hide() {
-    for (auto &callback : popup_hide_callbacks) {
-        try {
-            callback();
-        } catch (std::bad_any_cast &) {
-            Logger::error("Mismatched signal argument types!", "revector");
-        }
-    }
+    popup_hide_signal.emit();
 }
 
 } // namespace revector
@@ -89,10 +89,16 @@ public:
 
     std::string get_item_text(uint32_t item_index) const;
 
-    void connect_signal(const std::string &signal, const AnyCallable<void> &callback) override;
+    using NodeUi::connect_signal;
+
+    void connect_signal(SignalId signal, const AnyCallable<void> &callback) override;
 
     void calc_minimum_size() override;
 
+    // Signals.
+    TypedSignal<uint32_t> item_selected_signal;
+    TypedSignal<> popup_hide_signal;
+
 private:
     void when_item_selected(uint32_t item_index);
     void when_popup_hide();
@@ -107,10 +113,6 @@ private:
     float item_height_ = 48;
 
     std::optional<StyleBox> theme_bg_;
-
-    std::vector<AnyCallable<void>> item_selected_callbacks;
-
-    std::vector<AnyCallable<void>> popup_hide_callbacks;
 };
 
 } // namespace revector
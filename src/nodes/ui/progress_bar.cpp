@@ -47,6 +47,12 @@ void ProgressBar::update(double dt) {
     }
 }
 
+void ProgressBar::hash_draw_state(Pathfinder::Hasher &hasher) const {
+    NodeUi::hash_draw_state(hasher);
+
+    hasher.write_f32(ratio);
+}
+
 void ProgressBar::draw() {
     auto vector_server = VectorServer::get_singleton();
 
@@ -113,14 +119,14 @@ void ProgressBar::set_step(float new_step) {
 }
 
 void ProgressBar::value_changed() {
-    for (auto &callback : on_value_changed) {
-        callback();
-    }
+    value_changed_signal.emit();
 }
 
-void ProgressBar::connect_signal(const std::string &signal, const AnyCallable<void> &callback) {
-    if (signal == "on_value_changed") {
-        on_value_changed.push_back(callback);
+void ProgressBar::connect_signal(SignalId signal, const AnyCallable<void> &callback) {
+    NodeUi::connect_signal(signal, callback);
+
+    if (signal == SignalId::ValueChanged) {
+        value_changed_signal.connect(make_typed_slot<>(callback));
     }
 }
 
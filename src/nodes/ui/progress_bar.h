@@ -39,7 +39,9 @@ public:
 
     void value_changed();
 
-    void connect_signal(const std::string &signal, const AnyCallable<void> &callback) override;
+    using NodeUi::connect_signal;
+
+    void connect_signal(SignalId signal, const AnyCallable<void> &callback) override;
 
     void set_label_visibility(bool new_visibility);
 
@@ -47,6 +49,8 @@ public:
 
     void set_lerp_enabled(bool new_lerp_enabled);
 
+    TypedSignal<> value_changed_signal;
+
 protected:
     float value = 50;
     float target_value = 50;
@@ -63,7 +67,7 @@ protected:
 
     std::shared_ptr<Label> label;
 
-    std::vector<AnyCallable<void>> on_value_changed;
+    void hash_draw_state(Pathfinder::Hasher &hasher) const override;
 };
 
 } // namespace revector
@@ -106,6 +106,15 @@ void SpinBox::update(double dt) {
     NodeUi::update(dt);
 }
 
+void SpinBox::hash_draw_state(Pathfinder::Hasher &hasher) const {
+    NodeUi::hash_draw_state(hasher);
+
+    hasher.write_f32(value);
+    hasher.write_u64(focused);
+    hasher.write_u64(hovered);
+    hasher.write_u64(pressed);
+}
+
 void SpinBox::draw() {
     if (!visible_) {
         return;
@@ -145,24 +154,26 @@ void SpinBox::set_size(Vec2F p_size) {
 }
 
 void SpinBox::when_focused() {
-    for (auto &callback : focused_callbacks) {
-        callback();
-    }
+    focused_signal.emit();
 }
 
 void SpinBox::when_value_changed() {
-    for (auto &callback : value_changed_callbacks) {
-        callback();
-    }
+    value_changed_signal.emit(value);
 }
 
-void SpinBox::connect_signal(const std::string &signal, const AnyCallable<void> &callback) {
-    if (signal == "focused") {
-        focused_callbacks.push_back(callback);
-    }
-
-    if (signal == "value_changed") {
-        value_changed_callbacks.push_back(callback);
+void SpinBox::connect_signal(SignalId signal, const AnyCallable<void> &callback) {
+    NodeUi::connect_signal(signal, callback);
+
+    switch (signal) {
+        case SignalId::Focused: {
+            focused_signal.connect(make_typed_slot<>(callback));
+        } break;
+        case SignalId::ValueChanged: {
+            // Callbacks connected by name take no arguments.
+            value_changed_signal.connect([slot = make_typed_slot<>(callback)](float) mutable { slot(); });
+        } break;
+        default:
+            break;
     }
 }
 
@@ -36,12 +36,18 @@ public:
 
     void calc_minimum_size() override;
 
-    void connect_signal(const std::string& signal, const AnyCallable<void>& callback) override;
+    using NodeUi::connect_signal;
+
+    void connect_signal(SignalId signal, const AnyCallable<void>& callback) override;
 
     void set_value(float new_value);
 
     float get_value() const;
 
+    // Signals.
+    TypedSignal<> focused_signal;
+    TypedSignal<float> value_changed_signal;
+
 protected:
     float value = 0;
 
@@ -64,11 +70,10 @@ protected:
     std::shared_ptr<Button> increase_button, decrease_button;
     std::shared_ptr<Label> label;
 
-    std::vector<AnyCallable<void>> focused_callbacks;
-    std::vector<AnyCallable<void>> value_changed_callbacks;
-
     std::optional<StyleBox> theme_normal, theme_focused;
 
+    void hash_draw_state(Pathfinder::Hasher &hasher) const override;
+
 protected:
     void when_focused();
 
@@ -39,10 +39,10 @@ TextEdit::TextEdit() {
 
     set_text("Enter text");
 
-    callbacks_cursor_entered.emplace_back(
+    cursor_entered_signal.connect(
         [this] { InputServer::get_singleton()->set_cursor(get_window_index(), CursorShape::IBeam); });
 
-    callbacks_cursor_exited.emplace_back(
+    cursor_exited_signal.connect(
         [this] { InputServer::get_singleton()->set_cursor(get_window_index(), CursorShape::Arrow); });
 }
 
@@ -114,7 +114,7 @@ void TextEdit::input(InputEvent &event) {
                     delete_selection();
                 }
 
-                label->insert_text(current_caret_index, cpp11_codepoint_to_utf8(event.args.text.codepoint));
+                label->insert_text(current_caret_index, codepoint_to_utf8(event.args.text.codepoint));
 
                 current_caret_index++;
                 selection_start_index = current_caret_index;
@@ -195,7 +195,7 @@ void TextEdit::input(InputEvent &event) {
                     }
                     auto clipboard_text = input_server->get_clipboard(get_window_index());
                     std::u32string clipboard_text_u32;
-                    utf8_to_utf16(clipboard_text, clipboard_text_u32);
+                    utf8_to_utf32(clipboard_text, clipboard_text_u32);
                     label->insert_text(current_caret_index, clipboard_text);
                     current_caret_index += clipboard_text_u32.size();
                     selection_start_index = current_caret_index;
@@ -229,6 +229,19 @@ void TextEdit::update(double dt) {
     caret_blink_timer += dt;
 }
 
+void TextEdit::hash_draw_state(Pathfinder::Hasher &hasher) const {
+    NodeUi::hash_draw_state(hasher);
+
+    hasher.write_u64(editable);
+    hasher.write_u64(current_caret_index);
+    hasher.write_u64(selection_start_index);
+
+    // The caret blinks only when focused.
+    if (focused && editable) {
+        hasher.write_u64(std::sin(caret_blink_timer * 5.0f) > 0);
+    }
+}
+
 void TextEdit::draw() {
     auto vector_server = VectorServer::get_singleton();
 
@@ -37,6 +37,9 @@ public:
 
     void set_editable(bool new_value);
 
+protected:
+    void hash_draw_state(Pathfinder::Hasher &hasher) const override;
+
 private:
     bool editable = true;
     bool single_line = false;
@@ -16,6 +16,13 @@ TextureRect::TextureRect() {
 void TextureRect::set_texture(const std::shared_ptr<Image> &new_image) {
     // Texture can be null.
     texture = new_image;
+    pending_texture.reset();
+}
+
+void TextureRect::set_texture_async(const std::shared_ptr<AsyncResourceBase> &handle,
+                                    const std::shared_ptr<Image> &placeholder) {
+    set_texture(placeholder);
+    pending_texture = handle;
 }
 
 std::shared_ptr<Image> TextureRect::get_texture() const {
@@ -24,6 +31,22 @@ std::shared_ptr<Image> TextureRect::get_texture() const {
 
 void TextureRect::update(double dt) {
     NodeUi::update(dt);
+
+    if (pending_texture && pending_texture->is_ready()) {
+        auto loaded_image = std::dynamic_pointer_cast<Image>(pending_texture->get_resource());
+        pending_texture.reset();
+
+        if (loaded_image) {
+            texture = loaded_image;
+        }
+    }
+}
+
+void TextureRect::hash_draw_state(Pathfinder::Hasher &hasher) const {
+    NodeUi::hash_draw_state(hasher);
+
+    hasher.write_u64((uint64_t)texture.get());
+    hasher.write_u64((uint64_t)stretch_mode);
 }
 
 void TextureRect::draw() {
@@ -2,6 +2,7 @@
 
 #include <memory>
 
+#include "../../resources/resource_manager.h"
 #include "node_ui.h"
 
 namespace revector {
@@ -15,6 +16,11 @@ public:
 
     void set_texture(const std::shared_ptr<Image> &p_texture);
 
+    /// Show the placeholder until the image being loaded is ready.
+    /// The placeholder is kept if loading fails.
+    void set_texture_async(const std::shared_ptr<AsyncResourceBase> &handle,
+                           const std::shared_ptr<Image> &placeholder = nullptr);
+
     [[nodiscard]] std::shared_ptr<Image> get_texture() const;
 
     void calc_minimum_size() override;
@@ -37,9 +43,14 @@ public:
 protected:
     void update(double dt) override;
 
+    void hash_draw_state(Pathfinder::Hasher &hasher) const override;
+
     StretchMode stretch_mode = StretchMode::Scale;
 
     std::shared_ptr<Image> texture;
+
+    /// Image to replace the texture with once loaded.
+    std::shared_ptr<AsyncResourceBase> pending_texture;
 };
 
 } // namespace revector
@@ -1,8 +1,10 @@
 #include "tree.h"
 
+#include <algorithm>
 #include <string>
 
 #include "../../common/utils.h"
+#include "../../resources/resource_manager.h"
 #include "../scene_tree.h"
 
 namespace revector {
@@ -16,10 +18,22 @@ Tree::Tree() {
     theme_bg = std::make_optional(panel);
     panel.border_width = 2;
     theme_bg_focused = std::make_optional(panel);
+
+    theme_selected.bg_color = ColorU(100, 100, 100, 150);
+
+    // Shared by all rows.
+    auto resource_mgr = ResourceManager::get_singleton();
+    collapsed_tex = resource_mgr->load<VectorImage>("assets/icons/ArrowRight.svg");
+    expanded_tex = resource_mgr->load<VectorImage>("assets/icons/ArrowDown.svg");
 }
 
 void Tree::update(double dt) {
     NodeUi::update(dt);
+
+    // Rows are bound when drawing, so a cached rendering of the tree is stale once other rows get exposed.
+    if (root != nullptr && get_visible_row_range() != std::make_pair(first_row, last_row)) {
+        queue_redraw();
+    }
 }
 
 void Tree::draw() {
@@ -29,33 +43,85 @@ void Tree::draw() {
 
     auto vector_server = VectorServer::get_singleton();
 
+    auto global_position = get_global_position();
+
     if (theme_bg.has_value()) {
-        vector_server->draw_style_box(theme_bg.value(), get_global_position(), size);
+        vector_server->draw_style_box(theme_bg.value(), global_position, size);
     }
 
-    float offset_y = 0;
-    root->propagate_draw(folding_width, 0, offset_y, get_global_position());
+    if (root == nullptr) {
+        return;
+    }
+
+    layout_rows();
+
+    // Rows are not part of the scene tree, so we draw them as subtrees within our own clip.
+    vector_server->push_clip_rect(RectF(global_position, global_position + size));
+
+    for (uint32_t row_index = first_row; row_index < last_row; row_index++) {
+        auto &row = row_pool[row_index % row_pool.size()];
+
+        float offset_y = (float)row_index * item_height;
+
+        if (selected_item == row->item) {
+            vector_server->draw_style_box(
+                theme_selected, Vec2F(0, offset_y) + global_position, {size.x, item_height});
+        }
+
+        draw_subtree(row->container.get());
+    }
+
+    vector_server->pop_clip_rect();
 }
 
 void Tree::input(InputEvent &event) {
-    root->propagate_input(event, get_global_position());
+    if (root != nullptr && !row_pool.empty()) {
+        for (uint32_t row_index = first_row; row_index < last_row; row_index++) {
+            auto &row = row_pool[row_index % row_pool.size()];
+
+            if (row->item && !row->item->children.empty()) {
+                row->collapse_button->input(event);
+            }
+        }
+
+        if (event.type == InputEventType::MouseButton) {
+            auto button_event = event.args.mouse_button;
+            auto global_position = get_global_position();
+
+            if (!event.is_consumed() && button_event.pressed &&
+                RectF(global_position, global_position + size).contains_point(button_event.position)) {
+                auto row = (uint32_t)((button_event.position.y - global_position.y) / item_height);
+                auto item = get_item_at_row(row);
+
+                if (item) {
+                    if (selected_item) {
+                        selected_item->selected = false;
+                    }
+                    item->selected = true;
+                    selected_item = item;
+                    queue_redraw();
+                    Logger::verbose("Item selected: " + item->text, "revector");
+                }
+            }
+        }
+    }
 
     NodeUi::input(event);
 }
 
 std::shared_ptr<TreeItem> Tree::create_item(const std::shared_ptr<TreeItem> &parent, const std::string &text) {
+    // Items are small and usually created in large numbers.
+    auto item = std::allocate_shared<TreeItem>(PoolAllocator<TreeItem>());
+    item->set_text(text);
+    item->tree = this;
+
     if (parent == nullptr) {
-        root = std::make_shared<TreeItem>();
-        root->set_text(text);
-        root->tree = this;
+        root = item;
+        selected_item = nullptr;
         return root;
     }
 
-    auto item = std::make_shared<TreeItem>();
-    item->set_text(text);
     parent->add_child(item);
-    item->parent = parent.get();
-    item->tree = this;
 
     return item;
 }
@@ -64,63 +130,257 @@ void Tree::set_item_height(float new_item_height) {
     item_height = new_item_height;
 }
 
+void Tree::when_items_changed() {
+    items_changed = true;
+    queue_redraw();
+}
+
 float Tree::get_item_height() {
     return item_height;
 }
 
 void Tree::calc_minimum_size() {
-    Vec2F minimum_size;
-    uint32_t uncollapsed_item_count = 0;
-    root->propagate_calc_minimum_size(folding_width, 0, uncollapsed_item_count, minimum_size);
+    calculated_minimum_size = {max_row_width, item_height * get_visible_row_count()};
+}
 
-    calculated_minimum_size = {minimum_size.x, item_height * uncollapsed_item_count};
+uint32_t Tree::get_visible_row_count() const {
+    if (root == nullptr) {
+        return 0;
+    }
+    return root->visible_row_count;
 }
 
-TreeItem::TreeItem() {
-    label = std::make_shared<Label>();
-    label->container_sizing.expand_v = true;
-    label->container_sizing.flag_v = ContainerSizingFlag::Fill;
-    label->set_vertical_alignment(Alignment::Center);
-
-    icon = std::make_shared<TextureRect>();
-    icon->set_custom_minimum_size({24, 24});
-    icon->set_stretch_mode(TextureRect::StretchMode::KeepAspectCentered);
-
-    collapsed_tex = std::make_shared<VectorImage>("assets/icons/ArrowRight.svg");
-    expanded_tex = std::make_shared<VectorImage>("assets/icons/ArrowDown.svg");
-
-    collapse_button = std::make_shared<Button>();
-    collapse_button->set_icon_normal(expanded_tex);
-    collapse_button->set_text("");
-    collapse_button->set_icon_expand(true);
-    collapse_button->set_custom_minimum_size({24, 24});
-    collapse_button->theme_normal.border_width = 0;
-    collapse_button->theme_normal.bg_color = ColorU::transparent_black();
-
-    auto callback = [this] {
-        collapsed = !collapsed;
-        if (collapsed) {
-            collapse_button->set_icon_normal(collapsed_tex);
-        } else {
-            collapse_button->set_icon_normal(expanded_tex);
+TreeItem *Tree::get_item_at_row(uint32_t row) const {
+    if (row >= get_visible_row_count()) {
+        return nullptr;
+    }
+
+    auto item = root.get();
+
+    while (row > 0) {
+        // Skip the item's own row.
+        row -= 1;
+        item = item->children[item->find_child_by_row(row)].get();
+    }
+
+    return item;
+}
+
+std::optional<uint32_t> Tree::get_item_row(const TreeItem *item) const {
+    if (item == nullptr || item->tree != this) {
+        return {};
+    }
+
+    uint32_t row = 0;
+
+    for (auto current = item; current->parent; current = current->parent) {
+        if (current->parent->collapsed) {
+            return {};
         }
-    };
-    collapse_button->connect_signal("pressed", callback);
+        row += 1 + current->parent->get_children_row_count(current->index_in_parent);
+    }
 
-    container = std::make_shared<HBoxContainer>();
-    container->set_separation(0);
-    container->add_child(collapse_button);
-    container->add_child(icon);
-    container->add_child(label);
+    return row;
+}
 
-    collapse_button->container_sizing.expand_v = true;
-    collapse_button->container_sizing.flag_v = ContainerSizingFlag::Fill;
+void Tree::scroll_to_row(uint32_t row) {
+    for (auto node = parent; node; node = node->get_parent()) {
+        if (node->get_node_type() != NodeType::ScrollContainer) {
+            continue;
+        }
 
-    theme_selected.bg_color = ColorU(100, 100, 100, 150);
+        auto scroll_container = dynamic_cast<ScrollContainer *>(node);
+
+        // Offset of the tree in the scroll content.
+        float content_offset_y =
+            get_global_position().y - scroll_container->get_global_position().y + scroll_container->get_vscroll();
+
+        scroll_container->set_vscroll(content_offset_y + (float)row * item_height);
+        return;
+    }
+}
+
+std::pair<uint32_t, uint32_t> Tree::get_visible_row_range() const {
+    auto visible_rect = get_visible_rect();
+
+    if (!visible_rect.has_value()) {
+        return {0, 0};
+    }
+
+    auto global_position = get_global_position();
+
+    auto row_count = (float)get_visible_row_count();
+
+    float first = std::floor((visible_rect->top - global_position.y) / item_height);
+    float last = std::ceil((visible_rect->bottom - global_position.y) / item_height);
+
+    first = std::clamp(first - (float)overscan_rows, 0.0f, row_count);
+    last = std::clamp(last + (float)overscan_rows, first, row_count);
+
+    return {(uint32_t)first, (uint32_t)last};
+}
+
+std::unique_ptr<Tree::TreeRow> Tree::create_row() {
+    auto row = std::make_unique<TreeRow>();
+
+    row->label = make_node<Label>();
+    row->label->container_sizing.expand_v = true;
+    row->label->container_sizing.flag_v = ContainerSizingFlag::Fill;
+    row->label->set_vertical_alignment(Alignment::Center);
+
+    row->icon = make_node<TextureRect>();
+    row->icon->set_custom_minimum_size({24, 24});
+    row->icon->set_stretch_mode(TextureRect::StretchMode::KeepAspectCentered);
+
+    row->collapse_button = make_node<Button>();
+    row->collapse_button->set_text("");
+    row->collapse_button->set_icon_expand(true);
+    row->collapse_button->set_custom_minimum_size({24, 24});
+    row->collapse_button->theme_normal.border_width = 0;
+    row->collapse_button->theme_normal.bg_color = ColorU::transparent_black();
+    row->collapse_button->container_sizing.expand_v = true;
+    row->collapse_button->container_sizing.flag_v = ContainerSizingFlag::Fill;
+
+    // The row is owned by the pool, so the pointer stays valid.
+    auto row_ptr = row.get();
+    row->collapse_button->pressed_signal.connect([row_ptr] {
+        if (row_ptr->item) {
+            row_ptr->item->set_collapsed(!row_ptr->item->collapsed);
+        }
+    });
+
+    row->container = make_node<HBoxContainer>();
+    row->container->set_separation(0);
+    row->container->add_child(row->collapse_button);
+    row->container->add_child(row->icon);
+    row->container->add_child(row->label);
+
+    return row;
+}
+
+void Tree::bind_row(TreeRow &row, TreeItem *item) {
+    row.item = item;
+
+    row.label->set_text(item->text);
+    row.icon->set_texture(item->icon);
+
+    if (item->children.empty()) {
+        // We should make the button invisible by changing the alpha value instead of the visibility.
+        // Otherwise, the container layout will change and the intent will be gone.
+        row.collapse_button->modulate = ColorU::transparent_black();
+        row.collapse_button->set_icon_normal(nullptr);
+    } else {
+        row.collapse_button->modulate = ColorU::white();
+        row.collapse_button->set_icon_normal(item->collapsed ? collapsed_tex : expanded_tex);
+    }
+}
+
+void Tree::layout_rows() {
+    auto [new_first_row, new_last_row] = get_visible_row_range();
+
+    first_row = new_first_row;
+    last_row = new_last_row;
+
+    uint32_t row_count = last_row - first_row;
+    if (row_count == 0) {
+        return;
+    }
+
+    // Grow the pool if needed. The row mapping changes, so all rows get rebound.
+    if (row_pool.size() < row_count) {
+        while (row_pool.size() < row_count) {
+            row_pool.push_back(create_row());
+        }
+    }
+
+    auto item = get_item_at_row(first_row);
+
+    uint32_t depth = 0;
+    for (auto p = item->parent; p; p = p->parent) {
+        depth++;
+    }
+
+    auto global_position = get_global_position();
+
+    auto row_size = Vec2F(item_height, item_height);
+
+    std::vector<Node *> nodes;
+
+    for (uint32_t row_index = first_row; row_index < last_row && item; row_index++) {
+        auto &row = row_pool[row_index % row_pool.size()];
+
+        float offset_x = (float)depth * folding_width;
+        float offset_y = (float)row_index * item_height;
+
+        auto row_position = Vec2F(offset_x, offset_y) + global_position;
+
+        if (items_changed || row->item != item || row->layout_size != row_size) {
+            bind_row(*row, item);
+
+            row->container->set_position(row_position);
+            row->container->set_size(row_size);
+
+            revector::calc_minimum_size(row->container.get());
+
+            transform_system(row->container.get());
+
+            nodes.clear();
+            dfs_preorder_ltr_traversal(row->container.get(), nodes);
+            for (auto &node : nodes) {
+                node->update(0);
+            }
+
+            row->layout_position = row_position;
+            row->layout_size = row_size;
+
+            max_row_width = std::max(max_row_width, offset_x + row->container->get_effective_minimum_size().x);
+        } else if (row->layout_position != row_position) {
+            // Scrolled, the content of the row stays the same.
+            row->container->set_position(row_position);
+            transform_system(row->container.get());
+
+            row->layout_position = row_position;
+        }
+
+        // Move to the next visible item in preorder.
+        if (!item->collapsed && !item->children.empty()) {
+            item = item->children.front().get();
+            depth++;
+        } else {
+            while (item) {
+                auto item_parent = item->parent;
+                if (item_parent && item->index_in_parent + 1 < item_parent->children.size()) {
+                    item = item_parent->children[item->index_in_parent + 1].get();
+                    break;
+                }
+                item = item_parent;
+                depth--;
+            }
+        }
+    }
+
+    items_changed = false;
 }
 
 uint32_t TreeItem::add_child(const std::shared_ptr<TreeItem> &item) {
+    item->parent = this;
+    item->tree = tree;
+    item->index_in_parent = children.size();
+
     children.push_back(item);
+    children_row_counts.push_back(item->visible_row_count);
+
+    if (tree) {
+        tree->when_items_changed();
+    }
+
+    if (!collapsed) {
+        visible_row_count += item->visible_row_count;
+        if (parent) {
+            parent->when_child_row_count_changed(index_in_parent, item->visible_row_count);
+        }
+    }
+
     return children.size() - 1;
 }
 
@@ -144,123 +404,77 @@ TreeItem *TreeItem::get_parent() {
     return parent;
 }
 
-void TreeItem::propagate_input(InputEvent &event, Vec2F global_position) {
-    if (!children.empty()) {
-        collapse_button->input(event);
-    }
+void TreeItem::set_text(const std::string &new_text) {
+    text = new_text;
 
-    if (!collapsed) {
-        auto it = children.rbegin();
-        while (it != children.rend()) {
-            (*it)->propagate_input(event, global_position);
-            it++;
-        }
+    if (tree) {
+        tree->when_items_changed();
     }
-
-    input(event, global_position);
 }
 
-void TreeItem::propagate_draw(float folding_width, uint32_t depth, float &offset_y, Vec2F global_position) {
-    auto vector_server = VectorServer::get_singleton();
-
-    float offset_x = (float)depth * folding_width;
-
-    // Firstly, the item height will be decided by the minimum height of the icon and label.
-    float item_height = std::max(label->get_effective_minimum_size().y, icon->get_custom_minimum_size().y);
-
-    // Then the value set by the tree is considered.
-    item_height = std::max(tree->get_item_height(), item_height);
+std::string TreeItem::get_text() const {
+    return text;
+}
 
-    position = {offset_x, offset_y};
+void TreeItem::set_icon(const std::shared_ptr<Image> &texture) {
+    icon = texture;
 
-    if (tree->selected_item == this) {
-        vector_server->draw_style_box(
-            theme_selected, Vec2F(0, offset_y) + global_position, {tree->get_size().x, item_height});
+    if (tree) {
+        tree->when_items_changed();
     }
+}
 
-    if (children.empty()) {
-        // We should make the button invisible by changing the alpha value instead of the visibility.
-        // Otherwise, the container layout will change and the intent will be gone.
-        collapse_button->modulate = ColorU::transparent_black();
-
-        collapse_button->set_icon_normal(nullptr);
-    } else {
-        collapse_button->modulate = ColorU::white();
+void TreeItem::set_collapsed(bool new_collapsed) {
+    if (collapsed == new_collapsed) {
+        return;
     }
 
-    container->set_position(Vec2F(offset_x, offset_y) + global_position);
-    container->set_size({item_height, item_height});
-
-    calc_minimum_size(container.get());
-
-    transform_system(container.get());
+    collapsed = new_collapsed;
 
-    std::vector<Node *> nodes;
-    dfs_preorder_ltr_traversal(container.get(), nodes);
-    for (auto &node : nodes) {
-        node->update(0);
+    if (tree) {
+        tree->when_items_changed();
     }
 
-    draw_system(container.get());
+    uint32_t new_row_count = collapsed ? 1 : 1 + get_children_row_count(children.size());
 
-    offset_y += item_height;
+    int64_t delta = (int64_t)new_row_count - (int64_t)visible_row_count;
+    visible_row_count = new_row_count;
 
-    if (!collapsed) {
-        for (auto &child : children) {
-            child->propagate_draw(folding_width, depth + 1, offset_y, global_position);
-        }
+    if (parent && delta != 0) {
+        parent->when_child_row_count_changed(index_in_parent, delta);
     }
 }
 
-void TreeItem::propagate_calc_minimum_size(float folding_width,
-                                           uint32_t depth,
-                                           uint32_t &uncollapsed_item_count,
-                                           Vec2F &minimum_size) {
-    float offset_x = (float)depth * folding_width;
-
-    uncollapsed_item_count++;
-
-    // Firstly, the item height will be decided by the minimum height of the icon and label.
-    float item_height = std::max(label->get_effective_minimum_size().y, icon->get_custom_minimum_size().y);
+bool TreeItem::is_collapsed() const {
+    return collapsed;
+}
 
-    // Then the value set by the tree is considered.
-    item_height = std::max(tree->get_item_height(), item_height);
+uint32_t TreeItem::get_visible_row_count() const {
+    return visible_row_count;
+}
 
-    float item_width = label->get_effective_minimum_size().x + icon->get_custom_minimum_size().x;
-    minimum_size = minimum_size.max({item_width + offset_x, item_height});
+void TreeItem::when_child_row_count_changed(uint32_t child_index, int64_t delta) {
+    // Unsigned wrap-around takes care of negative deltas.
+    children_row_counts.add(child_index, (uint32_t)delta);
 
-    if (!collapsed) {
-        auto it = children.rbegin();
-        while (it != children.rend()) {
-            (*it)->propagate_calc_minimum_size(folding_width, depth + 1, uncollapsed_item_count, minimum_size);
-            it++;
-        }
+    // A collapsed item occupies a single row no matter how many rows its children have.
+    if (collapsed) {
+        return;
     }
-}
 
-void TreeItem::input(InputEvent &event, Vec2F global_position) {
-    float item_height = container->get_effective_minimum_size().y;
-    auto item_global_rect = (RectF(0, position.y, tree->get_size().x, position.y + item_height) + global_position);
+    visible_row_count = (uint32_t)((int64_t)visible_row_count + delta);
 
-    if (event.type == InputEventType::MouseButton) {
-        auto button_event = event.args.mouse_button;
-
-        if (!event.is_consumed() && button_event.pressed) {
-            if (item_global_rect.contains_point(button_event.position)) {
-                selected = true;
-                tree->selected_item = this;
-                Logger::verbose("Item selected: " + label->get_text(), "revector");
-            }
-        }
+    if (parent) {
+        parent->when_child_row_count_changed(index_in_parent, delta);
     }
 }
 
-void TreeItem::set_text(const std::string &text) {
-    label->set_text(text);
+uint32_t TreeItem::get_children_row_count(uint32_t count) const {
+    return children_row_counts.prefix_sum(count);
 }
 
-void TreeItem::set_icon(const std::shared_ptr<Image> &texture) {
-    icon->set_texture(texture);
+uint32_t TreeItem::find_child_by_row(uint32_t &row) const {
+    return children_row_counts.find(row);
 }
 
 } // namespace revector
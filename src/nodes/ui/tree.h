@@ -4,6 +4,7 @@
 #include <memory>
 #include <optional>
 
+#include "../../common/fenwick_tree.h"
 #include "../../common/geometry.h"
 #include "../../resources/font.h"
 #include "../../resources/style_box.h"
@@ -16,11 +17,12 @@ namespace revector {
 
 class Tree;
 
+/// A plain data record of a tree item. Widgets are only created for visible rows by the tree.
 class TreeItem {
     friend class Tree;
 
 public:
-    TreeItem();
+    TreeItem() = default;
 
     uint32_t add_child(const std::shared_ptr<TreeItem> &item);
 
@@ -32,43 +34,51 @@ public:
 
     TreeItem *get_parent();
 
-    void propagate_input(InputEvent &event, Vec2F global_position);
+    void set_text(const std::string &text);
 
-    void input(InputEvent &event, Vec2F global_position);
+    std::string get_text() const;
 
-    void propagate_draw(float folding_width, uint32_t depth, float &offset_y, Vec2F global_position);
+    void set_icon(const std::shared_ptr<Image> &image);
 
-    void propagate_calc_minimum_size(float folding_width, uint32_t depth, uint32_t &max_depth, Vec2F &minimum_size);
+    void set_collapsed(bool collapsed);
 
-    void set_text(const std::string &text);
+    bool is_collapsed() const;
 
-    void set_icon(const std::shared_ptr<Image> &image);
+    /// Number of rows this item and its expanded descendants occupy.
+    uint32_t get_visible_row_count() const;
 
 private:
-    bool collapsed = false;
-    bool selected = false;
-
-    // Local position in the tree.
-    Vec2F position;
+    /// Propagate a change of the visible row count of the child at `child_index` to the ancestors.
+    void when_child_row_count_changed(uint32_t child_index, int64_t delta);
 
-    std::shared_ptr<Button> collapse_button;
-    std::shared_ptr<VectorImage> collapsed_tex, expanded_tex;
+    /// Total visible rows of the first `count` children.
+    uint32_t get_children_row_count(uint32_t count) const;
 
-    std::shared_ptr<TextureRect> icon;
+    /// Find the child whose rows contain the given row (relative to the first child row).
+    uint32_t find_child_by_row(uint32_t &row) const;
 
-    std::shared_ptr<Label> label;
+    bool collapsed = false;
+    bool selected = false;
 
-    std::shared_ptr<HBoxContainer> container;
+    std::string text;
+    std::shared_ptr<Image> icon;
 
     std::vector<std::shared_ptr<TreeItem>> children;
-    TreeItem *parent;
+    TreeItem *parent{};
 
-    Tree *tree;
+    Tree *tree{};
 
-    StyleBox theme_selected;
+    uint32_t index_in_parent = 0;
+
+    uint32_t visible_row_count = 1;
+
+    /// Visible row counts of children, for logarithmic row lookups.
+    FenwickTree<uint32_t> children_row_counts;
 };
 
 class Tree : public NodeUi {
+    friend class TreeItem;
+
 public:
     Tree();
 
@@ -90,12 +100,71 @@ public:
 
     void calc_minimum_size() override;
 
+    /// Number of rows of all expanded items.
+    uint32_t get_visible_row_count() const;
+
+    /// Get the item shown at a row. Returns null if the row is out of range.
+    TreeItem *get_item_at_row(uint32_t row) const;
+
+    /// Get the row of an item, or nothing if the item is hidden inside a collapsed ancestor.
+    std::optional<uint32_t> get_item_row(const TreeItem *item) const;
+
+    /// Scroll the enclosing ScrollContainer so that the row is at the top.
+    void scroll_to_row(uint32_t row);
+
 private:
+    /// Reusable widgets for a visible row.
+    struct TreeRow {
+        std::shared_ptr<HBoxContainer> container;
+        std::shared_ptr<Button> collapse_button;
+        std::shared_ptr<TextureRect> icon;
+        std::shared_ptr<Label> label;
+
+        TreeItem *item{};
+
+        /// Global position and size of the last layout.
+        Vec2F layout_position;
+        Vec2F layout_size;
+    };
+
+    std::unique_ptr<TreeRow> create_row();
+
+    void bind_row(TreeRow &row, TreeItem *item);
+
+    /// Rows of the tree within the window and all ancestor scroll containers.
+    std::pair<uint32_t, uint32_t> get_visible_row_range() const;
+
+    /// Items in the visible row range, which are bound to the row widgets.
+    /// Only rows whose item, position or size changed are laid out again.
+    void layout_rows();
+
+    /// Called by items when their text, icon, children or collapsed state change.
+    void when_items_changed();
+
     float item_height = 32;
 
+    /// Extra rows bound above and below the visible ones.
+    uint32_t overscan_rows = 2;
+
     std::shared_ptr<TreeItem> root;
     std::optional<StyleBox> theme_bg;
     std::optional<StyleBox> theme_bg_focused;
+    StyleBox theme_selected;
+
+    std::shared_ptr<VectorImage> collapsed_tex, expanded_tex;
+
+    /// Row widgets are indexed by row % pool size, so only newly exposed rows are rebound when scrolling.
+    std::vector<std::unique_ptr<TreeRow>> row_pool;
+
+    /// Bound rows have to be rebound, as the data of some items changed.
+    bool items_changed = false;
+
+    /// Currently bound row range.
+    uint32_t first_row = 0;
+    uint32_t last_row = 0;
+
+    /// Widest row seen so far. Items are not measured until they are visible.
+    float max_row_width = 0;
 };
 
 } // namespace revector
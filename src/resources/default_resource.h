@@ -1,18 +1,17 @@
 #pragma once
 
+#include "../servers/text_server.h"
 #include "opensans_regular_ttf.h"
 #include "theme.h"
 
 namespace revector {
 
-class Font;
-
 class DefaultResource {
 public:
     DefaultResource() {
         default_theme = std::make_shared<Theme>();
-        default_font =
-            std::make_shared<Font>(std::vector<char>(std::begin(DEFAULT_FONT_DATA), std::end(DEFAULT_FONT_DATA)));
+        // The embedded data is used in place.
+        default_font = TextServer::get_singleton()->load_font_from_static_memory(DEFAULT_FONT_DATA, sizeof(DEFAULT_FONT_DATA));
     }
 
     static DefaultResource *get_singleton() {
@@ -1,9 +1,11 @@
 #include "font.h"
 
+#include <atomic>
 #include <string>
 #include <vector>
 
 #include "../common/load_file.h"
+#include "../common/mapped_file.h"
 #include "../common/utils.h"
 
 #define STB_TRUETYPE_IMPLEMENTATION
@@ -36,96 +38,58 @@
 #include <gzip/utils.hpp>
 #include <optional>
 
+#include "../servers/text_server.h"
 #include "default_resource.h"
 
 namespace revector {
 
 hb_script_t to_harfbuzz_script(Script script) {
-    switch (script) {
-        case Script::Arabic: {
-            return HB_SCRIPT_ARABIC;
-        }
-        case Script::Hebrew: {
-            return HB_SCRIPT_HEBREW;
-        }
-        case Script::Bengali: {
-            return HB_SCRIPT_BENGALI;
-        }
-        case Script::Devanagari: {
-            return HB_SCRIPT_DEVANAGARI;
-        }
-        case Script::Thai: {
-            return HB_SCRIPT_THAI;
-        }
-        case Script::Hiragana: {
-            return HB_SCRIPT_HIRAGANA;
-        }
-        case Script::Katakana: {
-            return HB_SCRIPT_KATAKANA;
-        }
-        default: {
-            return HB_SCRIPT_COMMON;
-        }
-    }
+    return (hb_script_t)script;
 }
 
-std::vector<std::pair<Script, Pathfinder::Range>> get_text_script(const std::u32string &utf32_text) {
-    std::vector<Script> scripts;
-
-    for (auto &codepoint : utf32_text) {
-        if (codepoint >= 0x0600 && codepoint <= 0x06FF) {
-            scripts.push_back(Script::Arabic);
-        } else if (codepoint >= 0x0981 && codepoint <= 0x09FB) {
-            scripts.push_back(Script::Bengali);
-        } else if (codepoint >= 0x0901 && codepoint <= 0x097F) {
-            scripts.push_back(Script::Devanagari);
-        } else if (codepoint >= 0x0590 && codepoint <= 0x05FF) {
-            scripts.push_back(Script::Hebrew);
-        } else if (codepoint >= 0x4E00 && codepoint <= 0x9FFF) {
-            scripts.push_back(Script::Cjk);
-        } else if (codepoint >= 0x3040 && codepoint <= 0x309F) {
-            scripts.push_back(Script::Hiragana);
-        } else if (codepoint >= 0x30A0 && codepoint <= 0x30FF) {
-            scripts.push_back(Script::Katakana);
-        } else if (codepoint >= 0x0E00 && codepoint <= 0x0E7F) {
-            scripts.push_back(Script::Thai);
-        } else {
-            scripts.push_back(Script::Common);
-        }
-    }
+namespace {
 
-    std::vector<std::pair<Script, Pathfinder::Range>> script_groups;
-    auto current_script = scripts.front();
-    uint32_t current_codepoint_start = 0;
-    for (uint32_t idx = 0; idx < scripts.size(); idx++) {
-        const auto &s = scripts[idx];
+/// Characters which don't decide the script of a run.
+bool is_neutral_script(Script script) {
+    return script == Script::Common || script == Script::Inherited || script == Script::Unknown;
+}
 
-        if (s != current_script) {
-            script_groups.emplace_back(current_script, Pathfinder::Range{current_codepoint_start, idx});
+} // namespace
 
-            current_script = s;
-            current_codepoint_start = idx;
-        }
-    }
+/// Split text into runs of the same script, looked up in HarfBuzz's Unicode Script property table.
+/// Common and inherited characters join the run they're in, or the following run at the start of the text.
+/// Never empty. Text of only neutral characters is one common run.
+std::vector<std::pair<Script, Pathfinder::Range>> get_text_script(const std::u32string &utf32_text) {
+    auto unicode_funcs = hb_unicode_funcs_get_default();
 
-    script_groups.emplace_back(current_script, Pathfinder::Range{current_codepoint_start, scripts.size()});
+    std::vector<std::pair<Script, Pathfinder::Range>> script_groups;
 
-    return script_groups;
-}
+    auto current_script = Script::Common;
+    uint32_t current_codepoint_start = 0;
 
-bool glyphs_exist_in_font(std::u32string codepoints, Font *font) {
-    assert(font != nullptr);
+    for (uint32_t idx = 0; idx < utf32_text.size(); idx++) {
+        auto script = (Script)hb_unicode_script(unicode_funcs, utf32_text[idx]);
 
-    for (const auto &c : codepoints) {
-        // Skip line breaks.
-        if (c == 0x000A) {
+        if (is_neutral_script(script) || script == current_script) {
             continue;
         }
-        if (font->find_glyph_index_by_codepoint(c) == 0) {
-            return false;
+
+        // Neutral characters so far belong to the first script.
+        if (current_script == Script::Common) {
+            current_script = script;
+            continue;
         }
+
+        script_groups.emplace_back(current_script, Pathfinder::Range{current_codepoint_start, idx});
+
+        current_script = script;
+        current_codepoint_start = idx;
     }
-    return true;
+
+    script_groups.emplace_back(current_script,
+                               Pathfinder::Range{current_codepoint_start, (uint32_t)utf32_text.size()});
+
+    return script_groups;
 }
 
 struct HarfBuzzData {
@@ -135,9 +99,9 @@ struct HarfBuzzData {
 
     HarfBuzzData() = default;
 
-    explicit HarfBuzzData(const std::vector<char> &bytes) {
-        // We need to keep bytes.data() valid for HarfBuzz to work properly.
-        blob = hb_blob_create(bytes.data(), bytes.size(), HB_MEMORY_MODE_READONLY, nullptr, nullptr);
+    HarfBuzzData(const unsigned char *data, size_t size) {
+        // We need to keep the data valid for HarfBuzz to work properly.
+        blob = hb_blob_create(reinterpret_cast<const char *>(data), size, HB_MEMORY_MODE_READONLY, nullptr, nullptr);
         face = hb_face_create(blob, 0);
         font = hb_font_create(face);
     }
@@ -155,44 +119,120 @@ struct HarfBuzzData {
     }
 };
 
-Font::Font(const std::string &path) : Resource(path) {
-    font_data = Pathfinder::load_file_as_bytes(path.c_str());
+namespace {
 
-    auto byte_size = font_data.size() * sizeof(unsigned char);
-    assert(byte_size != 0);
+uint32_t next_font_id() {
+    static std::atomic<uint32_t> counter = 0;
+    return ++counter;
+}
 
-    stbtt_buffer = static_cast<unsigned char *>(malloc(byte_size));
-    memcpy(stbtt_buffer, font_data.data(), byte_size);
+/// Outlines of a font dropped at once when exceeded.
+const size_t MAX_CACHED_GLYPH_OUTLINES = 4096;
 
-    // Prepare font info.
-    stbtt_info = new stbtt_fontinfo;
-    if (!stbtt_InitFont(stbtt_info, stbtt_buffer, 0)) {
-        Logger::error("Failed to prepare font info!", "revector");
+} // namespace
+
+void GlyphRun::clear() {
+    indices.clear();
+    face_indices.clear();
+    flags.clear();
+    advances.clear();
+    offsets.clear();
+    cluster_starts.clear();
+    cluster_lengths.clear();
+    faces.clear();
+}
+
+void GlyphRun::reserve(size_t glyph_count) {
+    indices.reserve(glyph_count);
+    face_indices.reserve(glyph_count);
+    flags.reserve(glyph_count);
+    advances.reserve(glyph_count);
+    offsets.reserve(glyph_count);
+    cluster_starts.reserve(glyph_count);
+    cluster_lengths.reserve(glyph_count);
+}
+
+void GlyphRun::push_back(uint16_t index,
+                         uint16_t face_index,
+                         uint8_t glyph_flags,
+                         float advance,
+                         Vec2F offset,
+                         uint32_t cluster_start,
+                         uint32_t cluster_end) {
+    indices.push_back(index);
+    face_indices.push_back(face_index);
+    flags.push_back(glyph_flags);
+    advances.push_back(advance);
+    offsets.push_back(offset);
+    cluster_starts.push_back(cluster_start);
+    cluster_lengths.push_back((uint16_t)std::min<uint32_t>(cluster_end - cluster_start, UINT16_MAX));
+}
+
+uint16_t GlyphRun::add_face(const GlyphFace &face) {
+    for (size_t i = 0; i < faces.size(); i++) {
+        if (faces[i].font == face.font && faces[i].font_size == face.font_size && faces[i].ascent == face.ascent &&
+            faces[i].descent == face.descent) {
+            return i;
+        }
     }
 
-    harfbuzz_data = std::make_shared<HarfBuzzData>(font_data);
+    faces.push_back(face);
+    return faces.size() - 1;
 }
 
-Font::Font(const std::vector<char> &bytes) {
-    font_data = bytes;
+RectF GlyphRun::get_box(size_t glyph) const {
+    const auto &face = get_face(glyph);
+
+    // Emojis are drawn in a square on top of the baseline.
+    if (has_flag(glyph, GLYPH_FLAG_EMOJI)) {
+        return {0, 0, advances[glyph], (float)face.font_size};
+    }
 
-    auto byte_size = font_data.size() * sizeof(unsigned char);
+    // The origin is the baseline. The Y axis is downward.
+    return {0, -face.ascent, advances[glyph], -face.descent};
+}
 
-    stbtt_buffer = static_cast<unsigned char *>(malloc(byte_size));
-    memcpy(stbtt_buffer, font_data.data(), byte_size);
+Font::Font(const std::string &path) : Resource(path), id(next_font_id()) {
+    // Pages of big fonts (e.g. CJK) are only loaded when used, and are shared between processes.
+    auto file = MappedFile::open(path);
+    if (file == nullptr) {
+        Logger::error("Failed to open font file " + path, "revector");
+    } else {
+        font_data = reinterpret_cast<const unsigned char *>(file->data());
+        font_data_size = file->size();
+        font_data_owner = file;
+    }
+
+    init();
+}
+
+Font::Font(std::vector<char> bytes) : id(next_font_id()) {
+    auto owned_bytes = std::make_shared<std::vector<char>>(std::move(bytes));
+
+    font_data = reinterpret_cast<const unsigned char *>(owned_bytes->data());
+    font_data_size = owned_bytes->size();
+    font_data_owner = owned_bytes;
+
+    init();
+}
+
+Font::Font(const unsigned char *data, size_t size, std::shared_ptr<const void> owner)
+    : font_data(data), font_data_size(size), font_data_owner(std::move(owner)), id(next_font_id()) {
+    init();
+}
 
+void Font::init() {
     // Prepare font info.
     stbtt_info = new stbtt_fontinfo;
-    if (!stbtt_InitFont(stbtt_info, stbtt_buffer, 0)) {
+    // stb_truetype doesn't write to the data.
+    if (!is_valid() || !stbtt_InitFont(stbtt_info, const_cast<unsigned char *>(font_data), 0)) {
         Logger::error("Failed to prepare font info!", "revector");
     }
 
-    harfbuzz_data = std::make_shared<HarfBuzzData>(font_data);
+    harfbuzz_data = std::make_shared<HarfBuzzData>(font_data, font_data_size);
 }
 
 Font::~Font() {
-    free(stbtt_buffer);
-
     delete stbtt_info;
 }
 
@@ -214,6 +254,10 @@ float Font::update_metrics(uint32_t size, float &ascent, float &descent) {
     return scale;
 }
 
+uint32_t Font::get_id() const {
+    return id;
+}
+
 std::string Font::get_glyph_svg(uint16_t glyph_index) const {
     const char *data{};
     size_t data_size = stbtt_GetGlyphSVG(stbtt_info, glyph_index, &data);
@@ -271,13 +315,42 @@ Pathfinder::Path2d Font::get_glyph_path(uint16_t glyph_index, float scale) const
     return path;
 }
 
+std::shared_ptr<const GlyphOutline> Font::get_glyph_outline(uint16_t glyph_index, uint32_t font_size) {
+    uint64_t key = (uint64_t)font_size << 16 | glyph_index;
+
+    {
+        std::lock_guard<std::mutex> lock(outline_cache_mutex);
+
+        auto iter = outline_cache.find(key);
+        if (iter != outline_cache.end()) {
+            return iter->second;
+        }
+    }
+
+    float scale = stbtt_ScaleForPixelHeight(stbtt_info, (float)font_size);
+
+    auto outline = std::make_shared<GlyphOutline>();
+    outline->path = get_glyph_path(glyph_index, scale);
+    // The Y axis points down.
+    outline->bbox = get_glyph_bounds(glyph_index, scale).to_f32();
+
+    std::lock_guard<std::mutex> lock(outline_cache_mutex);
+
+    if (outline_cache.size() >= MAX_CACHED_GLYPH_OUTLINES) {
+        outline_cache.clear();
+    }
+    outline_cache[key] = outline;
+
+    return outline;
+}
+
 #ifndef REVECTOR_USE_FRIBIDI
 
 // Not font fallback when using ICU.
 
 void Font::get_glyphs(const std::string &text,
                       uint32_t font_size,
-                      std::vector<Glyph> &glyphs,
+                      GlyphRun &glyphs,
                       std::vector<Line> &paragraphs) {
     glyphs.clear();
     paragraphs.clear();
@@ -303,6 +376,18 @@ void Font::get_glyphs(const std::string &text,
     const UChar *uchar_data = text_u16.c_str();
     const int32_t uchar_count = text_u16.length();
 
+    // Codepoint offset of each u16char offset, as run clusters are codepoint offsets into the whole text.
+    std::vector<uint32_t> codepoint_offsets(text_u16.size() + 1);
+    uint32_t codepoint_offset = 0;
+    for (size_t i = 0; i < text_u16.size(); i++) {
+        codepoint_offsets[i] = codepoint_offset;
+        // The low surrogate after a high one belongs to the same codepoint.
+        if (text_u16[i] < 0xD800 || text_u16[i] > 0xDBFF) {
+            codepoint_offset++;
+        }
+    }
+    codepoint_offsets.back() = codepoint_offset;
+
     // Bidi for the whole text (paragraphs).
     UBiDi *para_bidi = ubidi_open();
     // Bidi for a paragraph (lines).
@@ -385,6 +470,8 @@ void Font::get_glyphs(const std::string &text,
                 float ascent, descent;
                 float scale = update_metrics(font_size, ascent, descent);
 
+                uint16_t face_index = glyphs.add_face({shared_from_this(), font_size, ascent, descent});
+
                 // Buffers are sequences of Unicode characters that use the same font
                 // and have the same text direction, script, and language.
                 hb_buffer_t *hb_buffer = hb_buffer_create();
@@ -442,79 +529,40 @@ void Font::get_glyphs(const std::string &text,
                         }
                     }
 
-                    std::u16string glyph_text_u16 = text_u16.substr(current_cluster->start, current_cluster->length());
-
-                    std::string glyph_text = utf16_to_utf8(glyph_text_u16);
-                    //                    std::cout << "Glyph text: " << glyph_text << std::endl;
+                    // Cluster unit is u16char here.
+                    auto cluster_start = (uint32_t)current_cluster->start;
+                    auto cluster_end = (uint32_t)current_cluster->end;
 
-                    // One glyph may have multiple codepoints.
-                    // E.g. स् = स + ्
-                    std::u32string glyph_text_u32;
-                    utf8_to_utf32(glyph_text, glyph_text_u32);
-
-                    Glyph glyph;
-
-                    glyph.codepoints = glyph_text_u32;
-
-                    glyph.text = glyph_text;
-
-                    // Codepoint property is replaced with glyph ID after shaping.
-                    glyph.index = info.codepoint;
+                    uint8_t glyph_flags = 0;
+                    if (run_script == Script::Cjk) {
+                        glyph_flags |= GLYPH_FLAG_CJK;
+                    }
 
-                    glyph.script = run_script;
+                    Vec2F offset;
+                    float advance = 0;
 
                     // Mark line breaks, so they're not drawn.
-                    if (glyph_text == "\n") {
-                        glyph.skip_drawing = true;
+                    if (current_cluster->length() == 1 && text_u16[cluster_start] == u'\n') {
+                        glyph_flags |= GLYPH_FLAG_SKIP_DRAWING;
                     } else {
-                        glyph.x_offset = (float)pos.x_offset * scale;
-                        glyph.y_offset = (float)pos.y_offset * scale * -1.0;
-
-                        glyph.x_advance = (float)pos.x_advance * scale;
-
-                        // Debug
-                        // {
-                        //     int bitmap_width;
-                        //     int bitmap_height;
-                        //     int bitmap_xoffset;
-                        //     int bitmap_yoffset;
-                        //
-                        //     auto bitmap_data = stbtt_GetGlyphBitmap(&stbtt_info,
-                        //                                             scale,
-                        //                                             scale,
-                        //                                             glyph.index,
-                        //                                             &bitmap_width,
-                        //                                             &bitmap_height,
-                        //                                             &bitmap_xoffset,
-                        //                                             &bitmap_yoffset);
-                        //
-                        //     stbi_write_png(("glyph_bitmap_" + glyph.text + ".png").c_str(),
-                        //                    bitmap_width,
-                        //                    bitmap_height,
-                        //                    1,
-                        //                    bitmap_data,
-                        //                    bitmap_width);
-                        //
-                        //     int _ = 0;
-                        // }
-
-                        para_width += glyph.x_advance;
-
-                        // Get glyph path.
-                        glyph.path = get_glyph_path(glyph.index, scale);
-
-                        // The glyph's layout box in the glyph's local coordinates.
-                        // The origin is the baseline. The Y axis is downward.
-                        glyph.box = RectF(0, (float)-ascent, glyph.x_advance, (float)-descent);
-
-                        // Get the glyph path's bounding box. The Y axis points down.
-                        RectI bounding_box = get_glyph_bounds(glyph.index, scale);
-
-                        // BBox in the glyph's local coordinates.
-                        glyph.bbox = bounding_box.to_f32();
+                        if (current_cluster->length() == 1 && text_u16[cluster_start] == u' ') {
+                            glyph_flags |= GLYPH_FLAG_SPACE;
+                        }
+
+                        offset = {(float)pos.x_offset * scale, (float)pos.y_offset * scale * -1.0f};
+                        advance = (float)pos.x_advance * scale;
+
+                        para_width += advance;
                     }
 
-                    glyphs.push_back(glyph);
+                    // Codepoint property is replaced with glyph ID after shaping.
+                    glyphs.push_back(info.codepoint,
+                                     face_index,
+                                     glyph_flags,
+                                     advance,
+                                     offset,
+                                     codepoint_offsets[cluster_start],
+                                     codepoint_offsets[cluster_end]);
                 }
 
                 hb_buffer_destroy(hb_buffer);
@@ -539,7 +587,7 @@ void Font::get_glyphs(const std::string &text,
 
 void Font::get_glyphs(const std::string &text,
                       uint32_t font_size,
-                      std::vector<Glyph> &glyphs,
+                      GlyphRun &glyphs,
                       std::vector<Line> &paragraphs) {
     glyphs.clear();
     paragraphs.clear();
@@ -549,6 +597,9 @@ void Font::get_glyphs(const std::string &text,
     std::u32string text_u32;
     utf8_to_utf32(text, text_u32);
 
+    // Most codepoints map to one glyph.
+    glyphs.reserve(text_u32.size());
+
     // Separation into paragraphs.
     std::vector<Pathfinder::Range> para_ranges_unicode;
     {
@@ -673,8 +724,6 @@ void Font::get_glyphs(const std::string &text,
             para_is_rtl |= run_is_rtl;
         }
 
-        std::vector<Pathfinder::Range> para_clusters;
-
         // Go through runs.
         for (int32_t run_index = 0; run_index < run_count; run_index++) {
             signed char level = para_levels[run_index];
@@ -705,18 +754,17 @@ void Font::get_glyphs(const std::string &text,
                 uint32_t script_length = script_end - script_start;
 
                 std::u32string script_text_u32 = para_text_u32.substr(script_start, script_length);
-                bool use_fallback_font = !glyphs_exist_in_font(script_text_u32, this);
 
-                Font *font_to_use;
-                if (allow_fallback && use_fallback_font) {
-                    font_to_use = DefaultResource::get_singleton()->get_default_font().get();
-                } else {
-                    font_to_use = this;
+                Font *font_to_use = this;
+                if (allow_fallback) {
+                    font_to_use = TextServer::get_singleton()->resolve_font(this, script_text_u32);
                 }
 
                 float ascent, descent;
                 float scale = font_to_use->update_metrics(font_size, ascent, descent);
 
+                uint16_t face_index = glyphs.add_face({font_to_use->shared_from_this(), font_size, ascent, descent});
+
                 // Buffers are sequences of Unicode characters that use the same font
                 // and have the same text direction, script, and language.
                 hb_buffer_t *hb_buffer = hb_buffer_create();
@@ -777,85 +825,40 @@ void Font::get_glyphs(const std::string &text,
                         }
                     }
 
-                    para_clusters.push_back(*current_cluster);
-
-                    std::u32string glyph_text_u32 =
-                        para_text_u32.substr(current_cluster->start, current_cluster->length());
-
-                    std::string glyph_text = utf32_to_utf8(glyph_text_u32);
-                    //                    std::cout << "Glyph text: " << glyph_text << std::endl;
-
-                    Glyph glyph;
-
-                    glyph.start = current_cluster->start;
-                    glyph.end = current_cluster->end;
-
-                    glyph.ascent = ascent;
-                    glyph.descent = descent;
-
-                    // One glyph may have multiple codepoints.
-                    // E.g. स् = स + ्
-                    glyph.codepoints = glyph_text_u32;
+                    // HarfBuzz clusters are relative to the paragraph, while run clusters are relative to the text.
+                    auto cluster_start = (uint32_t)current_cluster->start;
+                    auto cluster_end = (uint32_t)current_cluster->end;
 
-                    glyph.text = glyph_text;
-
-                    // Codepoint property is replaced with glyph ID after shaping.
-                    glyph.index = info.codepoint;
+                    uint8_t glyph_flags = 0;
+                    if (script == Script::Cjk) {
+                        glyph_flags |= GLYPH_FLAG_CJK;
+                    }
 
-                    glyph.script = script;
+                    Vec2F offset;
+                    float advance = 0;
 
                     // Mark line breaks, so they're not drawn.
-                    if (glyph_text == "\n") {
-                        glyph.skip_drawing = true;
+                    if (current_cluster->length() == 1 && para_text_u32[cluster_start] == U'\n') {
+                        glyph_flags |= GLYPH_FLAG_SKIP_DRAWING;
                     } else {
-                        glyph.x_offset = (float)pos.x_offset * scale;
-                        glyph.y_offset = (float)pos.y_offset * scale * -1.0;
-
-                        glyph.x_advance = (float)pos.x_advance * scale;
-
-                        // Debug
-                        // {
-                        //     int bitmap_width;
-                        //     int bitmap_height;
-                        //     int bitmap_xoffset;
-                        //     int bitmap_yoffset;
-                        //
-                        //     auto bitmap_data = stbtt_GetGlyphBitmap(&stbtt_info,
-                        //                                             scale,
-                        //                                             scale,
-                        //                                             glyph.index,
-                        //                                             &bitmap_width,
-                        //                                             &bitmap_height,
-                        //                                             &bitmap_xoffset,
-                        //                                             &bitmap_yoffset);
-                        //
-                        //     stbi_write_png(("glyph_bitmap_" + glyph.text + ".png").c_str(),
-                        //                    bitmap_width,
-                        //                    bitmap_height,
-                        //                    1,
-                        //                    bitmap_data,
-                        //                    bitmap_width);
-                        //
-                        //     int _ = 0;
-                        // }
-
-                        para_width += glyph.x_advance;
-
-                        // Get glyph path.
-                        glyph.path = font_to_use->get_glyph_path(glyph.index, scale);
-
-                        // The glyph's layout box in the glyph's local coordinates.
-                        // The origin is the baseline. The Y axis is downward.
-                        glyph.box = RectF(0, -ascent, glyph.x_advance, -descent);
-
-                        // Get the glyph path's bounding box. The Y axis points down.
-                        RectI bounding_box = font_to_use->get_glyph_bounds(glyph.index, scale);
-
-                        // BBox in the glyph's local coordinates.
-                        glyph.bbox = bounding_box.to_f32();
+                        if (current_cluster->length() == 1 && para_text_u32[cluster_start] == U' ') {
+                            glyph_flags |= GLYPH_FLAG_SPACE;
+                        }
+
+                        offset = {(float)pos.x_offset * scale, (float)pos.y_offset * scale * -1.0f};
+                        advance = (float)pos.x_advance * scale;
+
+                        para_width += advance;
                     }
 
-                    glyphs.push_back(glyph);
+                    // Codepoint property is replaced with glyph ID after shaping.
+                    glyphs.push_back(info.codepoint,
+                                     face_index,
+                                     glyph_flags,
+                                     advance,
+                                     offset,
+                                     para_start + cluster_start,
+                                     para_start + cluster_end);
                 }
 
                 hb_buffer_destroy(hb_buffer);
@@ -867,7 +870,6 @@ void Font::get_glyphs(const std::string &text,
         para.glyph_ranges = {para_glyph_start, glyphs.size()};
         para.rtl = para_is_rtl;
         para.width = para_width;
-        para.clusters = para_clusters;
         paragraphs.push_back(para);
     }
 }
@@ -878,6 +880,22 @@ uint16_t Font::find_glyph_index_by_codepoint(int codepoint) {
     return stbtt_FindGlyphIndex(stbtt_info, codepoint);
 }
 
+bool Font::has_codepoint(uint32_t codepoint) const {
+    std::call_once(coverage_built, [this] {
+        hb_set_t *codepoints = hb_set_create();
+        hb_face_collect_unicodes(harfbuzz_data->face, codepoints);
+
+        hb_codepoint_t codepoint = HB_SET_VALUE_INVALID;
+        while (hb_set_next(codepoints, &codepoint)) {
+            coverage.insert(codepoint);
+        }
+
+        hb_set_destroy(codepoints);
+    });
+
+    return coverage.contains(codepoint);
+}
+
 RectI Font::get_glyph_bounds(uint16_t glyph_index, float scale) const {
     RectI bounding_box;
 
@@ -909,7 +927,7 @@ float Font::get_glyph_advance(uint16_t glyph_index, float scale) const {
 }
 
 bool Font::is_valid() const {
-    return !font_data.empty();
+    return font_data_size != 0;
 }
 
 } // namespace revector
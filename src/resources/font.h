@@ -2,175 +2,191 @@
 
 #include <pathfinder/prelude.h>
 
-#include <codecvt>
 #include <cstdio>
 #include <cstdlib>
-#include <locale>
+#include <mutex>
 
+#include "../common/codepoint_set.h"
 #include "../common/geometry.h"
+#include "../common/utf.h"
 #include "../common/utils.h"
-#include "resource.h"
+#include "resource_manager.h"
 
 struct stbtt_fontinfo;
 
 namespace revector {
 
-template <typename T>
-void utf8_to_utf16(const std::string &source, std::basic_string<T> &result) {
-    std::wstring_convert<std::codecvt_utf8_utf16<T>, T> convertor;
-    result = convertor.from_bytes(source);
+struct TextStyle {
+    ColorU color = ColorU::white();
+    ColorU stroke_color;
+    float stroke_width = 0;
+    bool italic = false;
+    bool bold = false;
+    bool debug = false;
+};
 
-    if (convertor.converted() < source.size()) {
-        throw std::runtime_error("Incomplete utf16-to-utf8 conversion!");
-    }
+constexpr uint32_t make_script_tag(char a, char b, char c, char d) {
+    return (uint32_t)a << 24 | (uint32_t)b << 16 | (uint32_t)c << 8 | (uint32_t)d;
 }
 
-template <typename T>
-std::string utf16_to_utf8(const std::basic_string<T> &source) {
-    std::wstring_convert<std::codecvt_utf8_utf16<T>, T> convertor;
-    std::string result = convertor.to_bytes(source);
+/// Unicode scripts as ISO 15924 tags, which are also the values of HarfBuzz's hb_script_t.
+/// Any script can be stored, but only some are named.
+enum class Script : uint32_t {
+    /// Punctuation, digits, spaces, etc., which are used with any script.
+    Common = make_script_tag('Z', 'y', 'y', 'y'),
+    /// Combining marks, which take the script of the preceding character.
+    Inherited = make_script_tag('Z', 'i', 'n', 'h'),
+    Unknown = make_script_tag('Z', 'z', 'z', 'z'),
+    Latin = make_script_tag('L', 'a', 't', 'n'),
+    Greek = make_script_tag('G', 'r', 'e', 'k'),
+    Cyrillic = make_script_tag('C', 'y', 'r', 'l'),
+    Arabic = make_script_tag('A', 'r', 'a', 'b'),
+    Bengali = make_script_tag('B', 'e', 'n', 'g'),
+    Devanagari = make_script_tag('D', 'e', 'v', 'a'),
+    Hebrew = make_script_tag('H', 'e', 'b', 'r'),
+    /// Han ideographs.
+    Cjk = make_script_tag('H', 'a', 'n', 'i'),
+    Hangul = make_script_tag('H', 'a', 'n', 'g'),
+    Hiragana = make_script_tag('H', 'i', 'r', 'a'),
+    Katakana = make_script_tag('K', 'a', 'n', 'a'),
+    Thai = make_script_tag('T', 'h', 'a', 'i'),
+};
 
-    if (convertor.converted() < source.size()) {
-        throw std::runtime_error("Incomplete utf8-to-utf16 conversion!");
-    }
+class Font;
+
+/// Properties of a shaped glyph, as bits.
+enum GlyphFlag : uint8_t {
+    /// Line breaks, which are neither drawn nor take space.
+    GLYPH_FLAG_SKIP_DRAWING = 1 << 0,
+    /// Drawn from the SVG data of the face's font instead of an outline.
+    GLYPH_FLAG_EMOJI = 1 << 1,
+    /// Shaped as Han ideographs, which lines can break between.
+    GLYPH_FLAG_CJK = 1 << 2,
+    /// The cluster is a space.
+    GLYPH_FLAG_SPACE = 1 << 3,
+    /// A line can break before this glyph. Set by the text layout, not by shaping.
+    GLYPH_FLAG_LINE_BREAKABLE = 1 << 4,
+};
 
-    return result;
-}
+/// Font and metrics shared by the glyphs shaped with the same font, of which a run has a few (one per fallback).
+struct GlyphFace {
+    std::shared_ptr<Font> font;
 
-template <typename T>
-void utf8_to_utf32(const std::string &source, std::basic_string<T> &result) {
-    std::wstring_convert<std::codecvt_utf8<char32_t>, T> convertor;
-    result = convertor.from_bytes(source);
+    uint32_t font_size = 0;
 
-    if (convertor.converted() < source.size()) {
-        throw std::runtime_error("Incomplete utf8-to-utf32 conversion!");
-    }
-}
-
-template <typename T>
-std::string utf32_to_utf8(const std::basic_string<T> &source) {
-    std::wstring_convert<std::codecvt_utf8<char32_t>, T> convertor;
-    std::string result = convertor.to_bytes(source);
+    float ascent = 0;
+    float descent = 0;
+};
 
-    if (convertor.converted() < source.size()) {
-        throw std::runtime_error("Incomplete utf32-to-utf8 conversion!");
-    }
+/// Glyph outline at a specific font size, shared by every text using it.
+struct GlyphOutline {
+    /// The points are in the glyph's baseline coordinates.
+    Pathfinder::Path2d path;
 
-    return result;
-}
+    /// The path's bounding box in the baseline coordinates, which has nothing to do with the glyph position in the
+    /// text paragraph.
+    RectF bbox;
+};
 
-// // This should convert to whatever the system-wide character encoding
-// // is for the platform (UTF-32/Linux - UCS-2/Windows)
-// std::string ws_to_utf8(std::wstring const &s) {
-//     std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> cnv;
-//     std::string utf8 = cnv.to_bytes(s);
-//     if (cnv.converted() < s.size()) {
-//         throw std::runtime_error("Incomplete wstring-to-utf8 conversion!");
-//     }
-//     return utf8;
-// }
-//
-// std::wstring utf8_to_ws(std::string const &utf8) {
-//     std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> cnv;
-//     std::wstring s = cnv.from_bytes(utf8);
-//     if (cnv.converted() < utf8.size()) {
-//         throw std::runtime_error("Incomplete utf8-to-wstring conversion!");
-//     }
-//     return s;
-// }
+/// Shaped glyphs as parallel arrays, which take 23 bytes per glyph.
+/// Outlines aren't stored, but looked up by glyph index with Font::get_glyph_outline() when drawing.
+/// Glyph count will not necessarily be the same as the codepoint count.
+struct GlyphRun {
+    /// Glyph index (font specific). Zero for invalid glyphs.
+    /// A particular glyph ID within the font does not necessarily correlate to a predictable Unicode codepoint.
+    std::vector<uint16_t> indices;
 
-struct TextStyle {
-    ColorU color = ColorU::white();
-    ColorU stroke_color;
-    float stroke_width = 0;
-    bool italic = false;
-    bool bold = false;
-    bool debug = false;
-};
+    /// Index into `faces`.
+    std::vector<uint16_t> face_indices;
 
-enum class Script {
-    Common = 0,
-    Arabic,
-    Bengali,
-    Devanagari,
-    Hebrew,
-    Cjk,
-    Hiragana,
-    Katakana,
-    Thai,
-};
+    /// GlyphFlag bits.
+    std::vector<uint8_t> flags;
 
-// Text-context-dependent glyph data.
-struct Glyph {
-    // Glyph index (font specific). Zero for invalid glyphs.
-    // A particular glyph ID within the font does not necessarily correlate to a predictable Unicode codepoint.
-    uint16_t index = 0;
+    /// Advance to the next glyph along the baseline.
+    std::vector<float> advances;
 
-    std::u32string codepoints;
+    /// Offset from the pen position on the baseline. The Y axis points down.
+    std::vector<Vec2F> offsets;
 
-    std::string text;
+    /// Codepoint range in the text. One cluster may have multiple glyphs, and one glyph multiple codepoints.
+    /// E.g. स् = स + ्
+    std::vector<uint32_t> cluster_starts;
+    std::vector<uint16_t> cluster_lengths;
 
-    // Start codepoint index in the text.
-    int start = 0;
+    std::vector<GlyphFace> faces;
 
-    // End codepoint index in the text.
-    int end = 0;
+    size_t size() const {
+        return indices.size();
+    }
 
-    bool emoji = false;
+    bool empty() const {
+        return indices.empty();
+    }
 
-    Script script = Script::Common;
+    void clear();
 
-    float x_offset = 0; // Offset from the origin of the glyph on baseline.
-    float y_offset = 0;
+    void reserve(size_t glyph_count);
 
-    float x_advance = 0; // Advance to the next glyph along baseline (x for horizontal layout, y for vertical).
-    float y_advance = 0;
+    void push_back(uint16_t index,
+                   uint16_t face_index,
+                   uint8_t glyph_flags,
+                   float advance,
+                   Vec2F offset,
+                   uint32_t cluster_start,
+                   uint32_t cluster_end);
 
-    float ascent = 0;
-    float descent = 0;
+    /// Returns the index of an equal face, adding it if there's none.
+    uint16_t add_face(const GlyphFace &face);
 
-    bool skip_drawing = false;
+    bool has_flag(size_t glyph, GlyphFlag flag) const {
+        return flags[glyph] & flag;
+    }
 
-    // Glyph path. The points are in the glyph's baseline coordinates.
-    Pathfinder::Path2d path;
+    const GlyphFace &get_face(size_t glyph) const {
+        return faces[face_indices[glyph]];
+    }
 
-    // Only emojis have SVG data.
-    //
-    // The points' origin is not top-left (like normal SVG images) but the font baseline,
-    // so the points don't fall in the view box specified by the image.
-    // Therefore, we need to pass an appropriate transform when appending the SVG scene.
-    std::string svg;
+    uint32_t get_cluster_end(size_t glyph) const {
+        return cluster_starts[glyph] + cluster_lengths[glyph];
+    }
 
     /// Glyph box in the baseline coordinates, which has nothing to do with the glyph position in the text paragraph.
-    RectF box;
-
-    /// Glyph path's bounding box in the baseline coordinates, which has nothing to do with the glyph position in the
-    /// text paragraph.
-    RectF bbox;
+    RectF get_box(size_t glyph) const;
 };
 
 struct Line {
     Pathfinder::Range glyph_ranges;
     bool rtl = false;
     float width = 0;
-    std::vector<Pathfinder::Range> clusters;
 };
 
 struct HarfBuzzData;
 
 // A font is pointsize-carefree.
-class Font : public Resource {
+// Fonts are always owned by shared pointers, as glyph runs keep the fonts they're shaped with.
+class Font : public Resource, public std::enable_shared_from_this<Font> {
 public:
+    /// The file is memory-mapped instead of read.
     explicit Font(const std::string &path);
 
-    explicit Font(const std::vector<char> &bytes);
+    explicit Font(std::vector<char> bytes);
+
+    /// Use font data stored elsewhere (e.g. embedded in the executable) without copying.
+    /// The data is kept alive by `owner`, which can be null for static data.
+    Font(const unsigned char *data, size_t size, std::shared_ptr<const void> owner);
 
     ~Font() override;
 
     bool is_valid() const;
 
+    /// A non-zero ID unique to this font within the process.
+    uint32_t get_id() const;
+
     Pathfinder::Path2d get_glyph_path(uint16_t glyph_index, float scale) const;
 
+    /// Outlines are cached by glyph index and font size, so texts using the same glyphs share them. Thread-safe.
+    std::shared_ptr<const GlyphOutline> get_glyph_outline(uint16_t glyph_index, uint32_t font_size);
+
     std::string get_glyph_svg(uint16_t glyph_index) const;
 
     /// Paragraphs and lines are different concepts.
@@ -178,11 +194,14 @@ public:
     /// A paragraph may contain one or more lines.
     void get_glyphs(const std::string &text,
                     uint32_t font_size,
-                    std::vector<Glyph> &glyphs,
+                    GlyphRun &glyphs,
                     std::vector<Line> &paragraphs);
 
     uint16_t find_glyph_index_by_codepoint(int codepoint);
 
+    /// Whether the font maps the codepoint to a glyph. The coverage is read from the cmap on first use.
+    bool has_codepoint(uint32_t codepoint) const;
+
     float get_glyph_advance(uint16_t glyph_index, float scale) const;
 
     RectI get_glyph_bounds(uint16_t glyph_index, float scale) const;
@@ -190,21 +209,35 @@ public:
     std::shared_ptr<HarfBuzzData> harfbuzz_data;
 
 private:
-    /// Stores font data, should not be freed until font is deleted.
-    unsigned char *stbtt_buffer{};
+    void init();
+
+    /// Raw font data, shared by stb_truetype and HarfBuzz. Kept alive by `font_data_owner`.
+    const unsigned char *font_data{};
+    size_t font_data_size = 0;
+
+    std::shared_ptr<const void> font_data_owner;
 
     stbtt_fontinfo *stbtt_info{};
 
+    uint32_t id;
+
     /// Will fall back to the default font for unfound glyphs.
     bool allow_fallback = true;
 
-    // Obsoleted, caching glyphs requires setting a font size, which we don't do to a font.
-    std::unordered_map<uint16_t, Glyph> glyph_cache;
+    /// Keyed by font size and glyph index.
+    std::unordered_map<uint64_t, std::shared_ptr<const GlyphOutline>> outline_cache;
+    std::mutex outline_cache_mutex;
 
-    // Raw font data, read directly from a file or from memory.
-    std::vector<char> font_data;
+    mutable CodepointSet coverage;
+    mutable std::once_flag coverage_built;
 
     float update_metrics(uint32_t size, float &ascent, float &descent);
 };
 
+/// Fonts are shared through the text server's registry. See TextServer::load_font_from_file().
+template <>
+struct ResourceFactory<Font> {
+    static std::shared_ptr<Font> create(const std::string &path);
+};
+
 } // namespace revector
@@ -1,16 +1,146 @@
 #include "raster_image.h"
 
+#include "../common/mapped_file.h"
 #include "../common/utils.h"
 
 // Already defined in Pathfinder.
 // #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
+#ifdef __ANDROID__
+    #include <sse2neon.h>
+#else
+    #include <emmintrin.h>
+#endif
+
+#include <cmath>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <stdexcept>
 
 namespace revector {
 
+namespace {
+
+const char RAW_IMAGE_MAGIC[4] = {'R', 'V', 'I', 'M'};
+
+const uint32_t RAW_IMAGE_VERSION = 1;
+
+/// Followed by width * height RGBA8 pixels.
+struct RawImageHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+};
+
+/// Map a raw image file. Returns null if it's invalid.
+std::shared_ptr<Pathfinder::Image> load_raw_image(const std::string &path) {
+    auto file = MappedFile::open(path);
+    if (file == nullptr || file->size() < sizeof(RawImageHeader)) {
+        return nullptr;
+    }
+
+    RawImageHeader header{};
+    std::memcpy(&header, file->data(), sizeof(header));
+
+    if (std::memcmp(header.magic, RAW_IMAGE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != RAW_IMAGE_VERSION || header.width == 0 || header.height == 0 ||
+        (file->size() - sizeof(header)) / sizeof(ColorU) / header.width < header.height) {
+        return nullptr;
+    }
+
+    auto pixels = reinterpret_cast<const ColorU *>(file->data() + sizeof(header));
+
+    return std::make_shared<Pathfinder::Image>(Vec2I(header.width, header.height), pixels, file);
+}
+
+/// Identifies the content of a file by its path and modification, so that images don't need to be hashed.
+/// Returns zero if the file can't be inspected.
+uint64_t get_file_content_key(const std::string &path) {
+    std::error_code error;
+    auto modified_time = std::filesystem::last_write_time(path, error);
+    if (error) {
+        return 0;
+    }
+    auto file_size = std::filesystem::file_size(path, error);
+    if (error) {
+        return 0;
+    }
+
+    auto source_key = std::filesystem::absolute(path, error).string() + ":" +
+                      std::to_string(modified_time.time_since_epoch().count()) + ":" + std::to_string(file_size);
+
+    return std::hash<std::string>()(source_key);
+}
+
+/// Halve the size with a 2x2 box filter. An odd last row or column is dropped.
+std::shared_ptr<Pathfinder::Image> downsample(const Pathfinder::Image &src) {
+    auto src_size = src.size;
+    auto dst_size = Vec2I(std::max(src_size.x / 2, 1), std::max(src_size.y / 2, 1));
+
+    std::vector<ColorU> dst_pixels(dst_size.area());
+
+    auto src_pixels = src.get_pixels();
+
+    for (int32_t y = 0; y < dst_size.y; y++) {
+        auto row0 = src_pixels + (size_t)std::min(y * 2, src_size.y - 1) * src_size.x;
+        auto row1 = src_pixels + (size_t)std::min(y * 2 + 1, src_size.y - 1) * src_size.x;
+        auto dst_row = dst_pixels.data() + (size_t)y * dst_size.x;
+
+        int32_t x = 0;
+
+        // Two destination pixels (four source pixels of each row) at a time.
+        if (src_size.x >= 2) {
+            auto zero = _mm_setzero_si128();
+            auto rounding = _mm_set1_epi16(2);
+
+            for (; x + 1 < dst_size.x; x += 2) {
+                auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 2));
+                auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 2));
+
+                // Sum the rows in 16 bits: pixels 0 and 1 in `lo`, pixels 2 and 3 in `hi`.
+                auto lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                auto hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+                // Sum horizontal pairs.
+                lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+                hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+                auto sum = _mm_unpacklo_epi64(lo, hi);
+                auto average = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(dst_row + x), _mm_packus_epi16(average, average));
+            }
+        }
+
+        for (; x < dst_size.x; x++) {
+            auto x0 = std::min(x * 2, src_size.x - 1);
+            auto x1 = std::min(x * 2 + 1, src_size.x - 1);
+
+            auto p0 = reinterpret_cast<const uint8_t *>(row0 + x0);
+            auto p1 = reinterpret_cast<const uint8_t *>(row0 + x1);
+            auto p2 = reinterpret_cast<const uint8_t *>(row1 + x0);
+            auto p3 = reinterpret_cast<const uint8_t *>(row1 + x1);
+
+            auto dst = reinterpret_cast<uint8_t *>(dst_row + x);
+            for (int c = 0; c < 4; c++) {
+                dst[c] = (p0[c] + p1[c] + p2[c] + p3[c] + 2) / 4;
+            }
+        }
+    }
+
+    return std::make_shared<Pathfinder::Image>(dst_size, std::move(dst_pixels));
+}
+
+/// Derive a content key from the image the data was generated from, so that it needn't be hashed.
+uint64_t derive_content_key(const Pathfinder::Image &src, uint64_t salt) {
+    return src.get_hash() * 0x100000001b3ull ^ salt;
+}
+
+} // namespace
+
 RasterImage::RasterImage(Vec2I size_) : Image(size_) {
     type = ImageType::Raster;
 }
@@ -18,24 +148,168 @@ RasterImage::RasterImage(Vec2I size_) : Image(size_) {
 RasterImage::RasterImage(const std::string &path) : Image(path) {
     type = ImageType::Raster;
 
-    // The STBI_rgb_alpha value forces the image to be loaded with an alpha channel,
-    // even if it doesn't have one, which is nice for consistency with other textures in the future.
-    int tex_width, tex_height, tex_channels;
-    stbi_uc *pixels = stbi_load(path.c_str(), &tex_width, &tex_height, &tex_channels, STBI_rgb_alpha);
+    if (std::filesystem::path(path).extension() == RAW_IMAGE_FILE_EXTENSION) {
+        image_data = load_raw_image(path);
+
+        if (!image_data) {
+            Logger::warn("Failed to load raw image file " + path, "revector");
+            throw std::runtime_error("Failed to load texture image!");
+        }
+    } else {
+        // The STBI_rgb_alpha value forces the image to be loaded with an alpha channel,
+        // even if it doesn't have one, which is nice for consistency with other textures in the future.
+        int tex_width, tex_height, tex_channels;
+        stbi_uc *pixels = stbi_load(path.c_str(), &tex_width, &tex_height, &tex_channels, STBI_rgb_alpha);
+
+        if (!pixels) {
+            Logger::warn("Failed to load image file " + path, "revector");
+            throw std::runtime_error("Failed to load texture image!");
+        }
+
+        // Use the decoded pixels in place, freeing them along with the image.
+        std::shared_ptr<const void> owner(pixels, [](const void *data) { stbi_image_free(const_cast<void *>(data)); });
+
+        image_data = std::make_shared<Pathfinder::Image>(
+            Vec2I(tex_width, tex_height), reinterpret_cast<const ColorU *>(pixels), std::move(owner));
+    }
+
+    size = image_data->size;
 
-    if (!pixels) {
-        Logger::warn("Failed to load image file " + path, "revector");
-        throw std::runtime_error("Failed to load texture image!");
+    // Hashing the pixels of large images is slow, and the file already identifies them.
+    auto content_key = get_file_content_key(path);
+    if (content_key != 0) {
+        image_data->set_content_key(content_key);
     }
+}
+
+bool RasterImage::save_raw(const std::string &path) const {
+    if (!image_data) {
+        return false;
+    }
+
+    RawImageHeader header{};
+    std::memcpy(header.magic, RAW_IMAGE_MAGIC, sizeof(header.magic));
+    header.version = RAW_IMAGE_VERSION;
+    header.width = image_data->size.x;
+    header.height = image_data->size.y;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(image_data->get_pixels()),
+               (std::streamsize)image_data->size.area() * sizeof(ColorU));
+
+    if (!file) {
+        Logger::warn("Failed to write raw image file: " + path, "revector");
+        return false;
+    }
+
+    return true;
+}
 
-    size = {tex_width, tex_height};
+uint32_t RasterImage::get_mip_level_count() const {
+    if (!image_data) {
+        return 0;
+    }
+
+    auto length = std::max(image_data->size.x, image_data->size.y);
 
-    std::vector<ColorU> bytes(tex_width * tex_height * 4);
-    memcpy(bytes.data(), pixels, bytes.size());
-    image_data = std::make_shared<Pathfinder::Image>(size, bytes);
+    uint32_t count = 1;
+    while (length > 1) {
+        length /= 2;
+        count++;
+    }
+
+    return count;
+}
+
+uint32_t RasterImage::select_mip_level(float screen_scale) const {
+    auto level_count = get_mip_level_count();
+    if (level_count == 0 || screen_scale <= 0) {
+        return 0;
+    }
+
+    auto level = (int32_t)std::floor(std::log2(1.0f / screen_scale));
+
+    return std::clamp(level, 0, (int32_t)level_count - 1);
+}
+
+std::shared_ptr<Pathfinder::Image> RasterImage::get_mip_level(uint32_t level) {
+    if (!image_data) {
+        return nullptr;
+    }
+
+    if (mip_levels.empty() || mip_levels[0] != image_data) {
+        mip_levels = {image_data};
+        tiles.clear();
+    }
 
-    // Clean up the original pixel array.
-    stbi_image_free(pixels);
+    level = std::min(level, get_mip_level_count() - 1);
+
+    while (mip_levels.size() <= level) {
+        auto &src = *mip_levels.back();
+        auto mip = downsample(src);
+        mip->set_content_key(derive_content_key(src, mip_levels.size()));
+        mip_levels.push_back(mip);
+    }
+
+    return mip_levels[level];
+}
+
+const RasterImage::Tile &RasterImage::get_tile(uint32_t level, Vec2I tile_coord) {
+    auto mip = get_mip_level(level);
+
+    if (level != tile_level) {
+        tiles.clear();
+        tile_level = level;
+    }
+
+    uint64_t key = (uint64_t)(uint32_t)tile_coord.y << 32 | (uint32_t)tile_coord.x;
+
+    tile_request_count++;
+
+    auto cached_tile = tiles.find(key);
+    if (cached_tile != tiles.end()) {
+        cached_tile->second.last_used = tile_request_count;
+        return cached_tile->second.tile;
+    }
+
+    auto mip_rect = RectI({}, mip->size);
+    auto tile_rect = RectI(tile_coord * RASTER_IMAGE_TILE_LENGTH, (tile_coord + 1) * RASTER_IMAGE_TILE_LENGTH)
+                         .intersection(mip_rect);
+
+    // Copy the tile with its apron.
+    auto apron_rect = tile_rect.dilate(1).intersection(mip_rect);
+
+    auto apron_size = apron_rect.size();
+    std::vector<ColorU> pixels(apron_size.area());
+
+    for (int32_t y = 0; y < apron_size.y; y++) {
+        auto src_row = mip->get_pixels() + (size_t)(apron_rect.top + y) * mip->size.x + apron_rect.left;
+        std::memcpy(pixels.data() + (size_t)y * apron_size.x, src_row, apron_size.x * sizeof(ColorU));
+    }
+
+    Tile tile;
+    tile.image = std::make_shared<Pathfinder::Image>(apron_size, std::move(pixels));
+    tile.image->set_content_key(derive_content_key(*mip, key + 1));
+    tile.rect = tile_rect;
+    tile.origin = apron_rect.origin();
+
+    auto &new_tile = tiles[key];
+    new_tile = {tile, tile_request_count};
+
+    return new_tile.tile;
+}
+
+void RasterImage::trim_tiles(size_t max_count) {
+    while (tiles.size() > max_count) {
+        auto oldest = tiles.begin();
+        for (auto iter = tiles.begin(); iter != tiles.end(); iter++) {
+            if (iter->second.last_used < oldest->second.last_used) {
+                oldest = iter;
+            }
+        }
+        tiles.erase(oldest);
+    }
 }
 
 } // namespace revector
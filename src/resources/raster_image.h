@@ -1,19 +1,72 @@
 #pragma once
 
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "../render/base.h"
 #include "image.h"
 
 namespace revector {
 
+/// Extension of uncompressed RGBA images, which are memory-mapped instead of decoded.
+const std::string RAW_IMAGE_FILE_EXTENSION = ".rvimage";
+
+/// Mip levels which don't fit in an atlas page are drawn in tiles of this size, so that only visible parts are uploaded.
+const int32_t RASTER_IMAGE_TILE_LENGTH = 512;
+
 class RasterImage final : public Image {
 public:
     RasterImage(Vec2I size_);
 
+    /// Load a PNG/JPEG/etc., or a raw image (see RAW_IMAGE_FILE_EXTENSION).
     explicit RasterImage(const std::string &path);
 
+    /// Save the pixels uncompressed, so that they can be memory-mapped when loaded again.
+    bool save_raw(const std::string &path) const;
+
+    /// A part of a mip level, with a one pixel apron of its neighbors so that filtering shows no seams.
+    struct Tile {
+        std::shared_ptr<Pathfinder::Image> image;
+        /// Region of the mip level covered by the tile, which is also the tile image region without the apron
+        /// when offset by `-origin`.
+        RectI rect;
+        Vec2I origin;
+    };
+
+    uint32_t get_mip_level_count() const;
+
+    /// The coarsest level which still has a pixel per screen pixel when drawn with the given scale.
+    uint32_t select_mip_level(float screen_scale) const;
+
+    /// Level 0 is the image itself, and each further level halves the size with a box filter.
+    /// Levels are generated on first use and kept.
+    std::shared_ptr<Pathfinder::Image> get_mip_level(uint32_t level);
+
+    /// Tiles of only the last requested level are kept, see trim_tiles().
+    const Tile &get_tile(uint32_t level, Vec2I tile_coord);
+
+    /// Keep at most `max_count` tiles, dropping the least recently requested ones,
+    /// so that panning a large level doesn't end up copying all of it into tiles.
+    void trim_tiles(size_t max_count);
+
     std::shared_ptr<Pathfinder::Image> image_data;
+
+private:
+    /// Dropped when image data changes.
+    std::vector<std::shared_ptr<Pathfinder::Image>> mip_levels;
+
+    uint32_t tile_level = 0;
+
+    struct CachedTile {
+        Tile tile;
+        uint64_t last_used = 0;
+    };
+
+    std::unordered_map<uint64_t, CachedTile> tiles;
+
+    /// Incremented on each tile request, to find the least recently used tiles.
+    uint64_t tile_request_count = 0;
 };
 
 } // namespace revector
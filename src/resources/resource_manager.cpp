@@ -1 +1,74 @@
 #include "resource_manager.h"
+
+#include <chrono>
+
+namespace revector {
+
+namespace {
+
+/// Time spent per frame on loads which have to run on the main thread.
+const std::chrono::milliseconds MAIN_THREAD_LOAD_BUDGET(4);
+
+} // namespace
+
+std::shared_ptr<Resource> ResourceManager::find(const std::string &path) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = resources.find(path);
+    if (it == resources.end()) {
+        return nullptr;
+    }
+    return it->second.lock();
+}
+
+void ResourceManager::poll() {
+    std::vector<MainThreadJob> jobs;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.swap(main_thread_jobs);
+    }
+
+    // Spread main thread loads over frames. At least one job runs per frame.
+    auto start_time = std::chrono::steady_clock::now();
+    size_t job_index = 0;
+    std::vector<FinishedLoad> main_thread_loads;
+
+    for (; job_index < jobs.size(); job_index++) {
+        if (job_index > 0 && std::chrono::steady_clock::now() - start_time > MAIN_THREAD_LOAD_BUDGET) {
+            break;
+        }
+        auto &job = jobs[job_index];
+        main_thread_loads.push_back({job.path, job.load()});
+    }
+
+    std::vector<std::pair<std::shared_ptr<AsyncResourceBase>, std::shared_ptr<Resource>>> completions;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Keep the order of the remaining jobs ahead of ones queued meanwhile.
+        main_thread_jobs.insert(main_thread_jobs.begin(),
+                                std::make_move_iterator(jobs.begin() + job_index),
+                                std::make_move_iterator(jobs.end()));
+
+        finished.insert(finished.end(),
+                        std::make_move_iterator(main_thread_loads.begin()),
+                        std::make_move_iterator(main_thread_loads.end()));
+
+        for (auto &load : finished) {
+            auto it = pending.find(load.path);
+            if (it == pending.end()) {
+                continue;
+            }
+            completions.emplace_back(it->second, std::move(load.resource));
+            pending.erase(it);
+        }
+        finished.clear();
+    }
+
+    // Emit without holding the lock, as slots may start new loads.
+    for (auto &completion : completions) {
+        completion.first->complete(completion.second);
+    }
+}
+
+} // namespace revector
@@ -1,9 +1,15 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 
+#include "../common/signal.h"
+#include "../common/utils.h"
+#include "../common/worker_pool.h"
 #include "resource.h"
 
 namespace revector {
@@ -12,6 +18,66 @@ struct ResId {
     uint64_t unique_id;
 };
 
+/// Whether a resource type can be constructed on a worker thread.
+/// Specialize as false for types that use main thread state (e.g. the vector canvas or the render device).
+template <typename T>
+struct LoadsOffMainThread : std::true_type {};
+
+/// How a resource type is created from a path. By default, its constructor loads it.
+/// Specialize for types whose instances are owned by a server (e.g. fonts).
+template <typename T>
+struct ResourceFactory {
+    static std::shared_ptr<T> create(const std::string &path) {
+        return std::make_shared<T>(path);
+    }
+};
+
+/// Untyped part of an async load, so that nodes can hold loads of any type.
+class AsyncResourceBase {
+public:
+    virtual ~AsyncResourceBase() = default;
+
+    /// Only changes on the main thread, in ResourceManager::poll().
+    bool is_ready() const {
+        return ready;
+    }
+
+    /// Null until ready, or if loading failed.
+    std::shared_ptr<Resource> get_resource() const {
+        return resource;
+    }
+
+protected:
+    friend class ResourceManager;
+
+    virtual void complete(const std::shared_ptr<Resource> &loaded_resource) = 0;
+
+    bool ready = false;
+
+    std::shared_ptr<Resource> resource;
+};
+
+/// Handle of a resource being loaded in the background.
+template <typename T>
+class AsyncResource final : public AsyncResourceBase {
+public:
+    /// Null until ready, or if loading failed.
+    std::shared_ptr<T> get() const {
+        return std::static_pointer_cast<T>(resource);
+    }
+
+    /// Emitted on the main thread when loading finishes. The resource is null if loading failed.
+    TypedSignal<std::shared_ptr<T>> loaded_signal;
+
+protected:
+    void complete(const std::shared_ptr<Resource> &loaded_resource) override {
+        // Don't hand out a resource of another type.
+        resource = std::dynamic_pointer_cast<T>(loaded_resource);
+        ready = true;
+        loaded_signal.emit(get());
+    }
+};
+
 class ResourceManager {
 public:
     static ResourceManager *get_singleton() {
@@ -19,14 +85,25 @@ public:
         return &singleton;
     }
 
+    /// Thread-safe.
     template <typename T>
     std::shared_ptr<T> load(const std::string &path) {
         static_assert(std::is_base_of<Resource, T>::value, "T must inherit from Resource!");
 
-        auto res = resources[path].lock();
+        auto res = find(path);
         if (!res) {
-            // assuming constructor loads resource
-            resources[path] = res = std::make_shared<T>(path);
+            // Don't hold the lock meanwhile, as loading can be slow.
+            std::shared_ptr<Resource> new_res = ResourceFactory<T>::create(path);
+            if (!new_res) {
+                throw std::runtime_error("Failed to load resource '" + path + "'!");
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            // Another thread may have loaded it meanwhile.
+            res = resources[path].lock();
+            if (!res) {
+                resources[path] = res = new_res;
+            }
         }
 
         auto return_value = std::dynamic_pointer_cast<T>(res);
@@ -37,8 +114,85 @@ public:
         return return_value;
     }
 
+    /// Load a resource in the background. Requests for a path which is already being loaded share the handle.
+    /// The handle is completed in poll(), even if the resource is already loaded.
+    template <typename T>
+    std::shared_ptr<AsyncResource<T>> load_async(const std::string &path) {
+        static_assert(std::is_base_of<Resource, T>::value, "T must inherit from Resource!");
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto pending_it = pending.find(path);
+        if (pending_it != pending.end()) {
+            auto handle = std::dynamic_pointer_cast<AsyncResource<T>>(pending_it->second);
+            if (!handle) {
+                throw std::runtime_error("Resource '" + path + "' is already being loaded as another type!");
+            }
+            return handle;
+        }
+
+        auto handle = std::make_shared<AsyncResource<T>>();
+        pending[path] = handle;
+
+        auto res = resources[path].lock();
+        if (res) {
+            finished.push_back({path, res});
+            return handle;
+        }
+
+        auto job = [this, path]() -> std::shared_ptr<Resource> {
+            try {
+                return load<T>(path);
+            } catch (const std::exception &e) {
+                Logger::error("Failed to load resource '" + path + "': " + e.what(), "revector");
+                return nullptr;
+            }
+        };
+
+        if constexpr (LoadsOffMainThread<T>::value) {
+            workers.submit([this, path, job]() mutable {
+                auto loaded_resource = job();
+
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.push_back({path, loaded_resource});
+            });
+        } else {
+            main_thread_jobs.push_back({path, std::move(job)});
+        }
+
+        return handle;
+    }
+
+    /// Complete finished async loads and emit their signals. Called by the scene tree once per frame.
+    void poll();
+
 private:
+    std::shared_ptr<Resource> find(const std::string &path);
+
+    struct FinishedLoad {
+        std::string path;
+        std::shared_ptr<Resource> resource;
+    };
+
+    struct MainThreadJob {
+        std::string path;
+        Callable<std::shared_ptr<Resource>()> load;
+    };
+
+    /// Guards all members below, except the worker pool.
+    std::mutex mutex;
+
     std::unordered_map<std::string, std::weak_ptr<Resource>> resources;
+
+    std::unordered_map<std::string, std::shared_ptr<AsyncResourceBase>> pending;
+
+    std::vector<FinishedLoad> finished;
+
+    /// Loads of types which can't be constructed on a worker thread.
+    std::vector<MainThreadJob> main_thread_jobs;
+
+    /// Declared last, so that its threads are joined before the state they use is destroyed.
+    WorkerPool workers;
 };
 
 } // namespace revector
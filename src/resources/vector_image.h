@@ -6,6 +6,7 @@
 
 #include "../common/geometry.h"
 #include "image.h"
+#include "resource_manager.h"
 
 namespace revector {
 
@@ -42,4 +43,8 @@ protected:
     std::shared_ptr<Pathfinder::SvgScene> svg_scene;
 };
 
+/// SVG parsing draws with the vector server's canvas.
+template <>
+struct LoadsOffMainThread<VectorImage> : std::false_type {};
+
 } // namespace revector
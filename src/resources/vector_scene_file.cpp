@@ -0,0 +1,358 @@
+#include "vector_scene_file.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "../common/geometry.h"
+#include "../common/mapped_file.h"
+#include "../common/utils.h"
+
+namespace revector {
+
+namespace {
+
+const char VECTOR_SCENE_MAGIC[4] = {'R', 'V', 'S', 'C'};
+
+/// Bump when the layout changes, so that old files are ignored.
+const uint32_t VECTOR_SCENE_VERSION = 1;
+
+// All records are 4-byte aligned.
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t source_key_size;
+    uint32_t paint_count;
+    uint32_t clip_path_count;
+    uint32_t draw_path_count;
+    float size[2];
+    float view_box[4];
+};
+
+struct PathHeader {
+    /// -1 if not clipped.
+    int32_t clip_path;
+    /// Unused for clip paths.
+    uint32_t paint;
+    uint8_t fill_rule;
+    uint8_t blend_mode;
+    uint16_t reserved;
+    uint32_t contour_count;
+    float bounds[4];
+};
+
+// Followed by the points, then one byte per point flag.
+struct ContourHeader {
+    uint32_t point_count;
+    uint32_t closed;
+    float bounds[4];
+};
+
+size_t align4(size_t size) {
+    return (size + 3) & ~(size_t)3;
+}
+
+class Writer {
+public:
+    template <typename T>
+    void write(const T &value) {
+        write_bytes(&value, sizeof(T));
+    }
+
+    void write_bytes(const void *data, size_t size) {
+        auto bytes = static_cast<const char *>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+        buffer.resize(align4(buffer.size()));
+    }
+
+    std::vector<char> buffer;
+};
+
+/// Bounds-checked reads from a mapped file.
+class Reader {
+public:
+    Reader(const char *_data, size_t _size) : data(_data), size(_size) {}
+
+    template <typename T>
+    bool read(T &value) {
+        auto bytes = read_bytes(sizeof(T));
+        if (bytes == nullptr) {
+            return false;
+        }
+        std::memcpy(&value, bytes, sizeof(T));
+        return true;
+    }
+
+    /// Returns null if there's not enough data left.
+    const char *read_bytes(size_t count) {
+        if (count > size - offset) {
+            return nullptr;
+        }
+        auto bytes = data + offset;
+        offset = std::min(size, offset + align4(count));
+        return bytes;
+    }
+
+    size_t remaining() const {
+        return size - offset;
+    }
+
+private:
+    const char *data;
+    size_t size;
+    size_t offset = 0;
+};
+
+void write_rect(float (&dst)[4], const RectF &rect) {
+    dst[0] = rect.left;
+    dst[1] = rect.top;
+    dst[2] = rect.right;
+    dst[3] = rect.bottom;
+}
+
+RectF read_rect(const float (&src)[4]) {
+    return {src[0], src[1], src[2], src[3]};
+}
+
+void write_outline(Writer &writer, const Pathfinder::Outline &outline) {
+    for (auto &contour : outline.contours) {
+        ContourHeader contour_header{};
+        contour_header.point_count = contour.points.size();
+        contour_header.closed = contour.closed;
+        write_rect(contour_header.bounds, contour.bounds);
+        writer.write(contour_header);
+
+        writer.write_bytes(contour.points.data(), contour.points.size() * sizeof(Vec2F));
+
+        std::vector<uint8_t> flags(contour.flags.size());
+        for (size_t i = 0; i < flags.size(); i++) {
+            flags[i] = (uint8_t)contour.flags[i];
+        }
+        writer.write_bytes(flags.data(), flags.size());
+    }
+}
+
+bool read_outline(Reader &reader,
+                  const PathHeader &path_header,
+                  Pathfinder::Arena &arena,
+                  Pathfinder::Outline &outline) {
+    outline.bounds = read_rect(path_header.bounds);
+    // Counts of a corrupt file mustn't drive allocations, so check them against the bytes left first.
+    if (path_header.contour_count > reader.remaining() / sizeof(ContourHeader)) {
+        return false;
+    }
+
+    outline.contours = Pathfinder::ArenaVector<Pathfinder::Contour>(&arena);
+    outline.contours.reserve(path_header.contour_count);
+
+    for (uint32_t i = 0; i < path_header.contour_count; i++) {
+        ContourHeader contour_header{};
+        if (!reader.read(contour_header)) {
+            return false;
+        }
+
+        auto point_count = contour_header.point_count;
+        // Each point takes a position and a flag byte.
+        if (point_count > reader.remaining() / (sizeof(Vec2F) + 1)) {
+            return false;
+        }
+
+        auto points = reader.read_bytes((size_t)point_count * sizeof(Vec2F));
+        auto flags = reinterpret_cast<const uint8_t *>(reader.read_bytes(point_count));
+        if (points == nullptr || flags == nullptr) {
+            return false;
+        }
+
+        Pathfinder::Contour contour;
+        contour.closed = contour_header.closed != 0;
+        contour.bounds = read_rect(contour_header.bounds);
+
+        contour.points = Pathfinder::ArenaVector<Vec2F>(point_count, &arena);
+        std::memcpy(contour.points.data(), points, (size_t)point_count * sizeof(Vec2F));
+
+        contour.flags = Pathfinder::ArenaVector<Pathfinder::PointFlag>(&arena);
+        contour.flags.reserve(point_count);
+        for (uint32_t j = 0; j < point_count; j++) {
+            if (flags[j] > (uint8_t)Pathfinder::PointFlag::CONTROL_POINT_1) {
+                return false;
+            }
+            contour.flags.push_back((Pathfinder::PointFlag)flags[j]);
+        }
+
+        outline.contours.push_back(std::move(contour));
+    }
+
+    return true;
+}
+
+} // namespace
+
+bool save_vector_scene(const Pathfinder::SvgScene &svg_scene, const std::string &path, const std::string &source_key) {
+    auto scene = svg_scene.get_scene();
+    if (scene == nullptr || !scene->instances.empty() || !scene->palette.is_solid_colors_only()) {
+        return false;
+    }
+
+    for (auto &display_item : scene->display_list) {
+        if (display_item.type != Pathfinder::DisplayItem::Type::DrawPaths) {
+            return false;
+        }
+    }
+
+    Writer writer;
+
+    FileHeader header{};
+    std::memcpy(header.magic, VECTOR_SCENE_MAGIC, sizeof(header.magic));
+    header.version = VECTOR_SCENE_VERSION;
+    header.source_key_size = source_key.size();
+    header.paint_count = scene->palette.get_paint_count();
+    header.clip_path_count = scene->clip_paths.size();
+    header.draw_path_count = scene->draw_paths.size();
+    header.size[0] = svg_scene.get_size().x;
+    header.size[1] = svg_scene.get_size().y;
+    write_rect(header.view_box, scene->get_view_box());
+    writer.write(header);
+
+    writer.write_bytes(source_key.data(), source_key.size());
+
+    for (uint32_t i = 0; i < header.paint_count; i++) {
+        auto color = scene->palette.get_paint(i).get_base_color();
+        uint8_t rgba[4] = {color.r_, color.g_, color.b_, color.a_};
+        writer.write(rgba);
+    }
+
+    for (auto &clip_path : scene->clip_paths) {
+        PathHeader path_header{};
+        path_header.clip_path = clip_path.clip_path ? (int32_t)*clip_path.clip_path : -1;
+        path_header.fill_rule = (uint8_t)clip_path.fill_rule;
+        path_header.contour_count = clip_path.outline.contours.size();
+        write_rect(path_header.bounds, clip_path.outline.bounds);
+        writer.write(path_header);
+
+        write_outline(writer, clip_path.outline);
+    }
+
+    for (auto &draw_path : scene->draw_paths) {
+        PathHeader path_header{};
+        path_header.clip_path = draw_path.clip_path ? (int32_t)*draw_path.clip_path : -1;
+        path_header.paint = draw_path.paint;
+        path_header.fill_rule = (uint8_t)draw_path.fill_rule;
+        path_header.blend_mode = (uint8_t)draw_path.blend_mode;
+        path_header.contour_count = draw_path.outline.contours.size();
+        write_rect(path_header.bounds, draw_path.outline.bounds);
+        writer.write(path_header);
+
+        write_outline(writer, draw_path.outline);
+    }
+
+    // Write to a temporary file first, so that a concurrent load never sees a partial file.
+    std::error_code error;
+    auto file_path = std::filesystem::path(path);
+    if (file_path.has_parent_path()) {
+        std::filesystem::create_directories(file_path.parent_path(), error);
+    }
+
+    auto temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.write(writer.buffer.data(), (std::streamsize)writer.buffer.size())) {
+            Logger::warn("Failed to write vector scene file: " + path, "revector");
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+
+    return true;
+}
+
+std::shared_ptr<Pathfinder::SvgScene> load_vector_scene(const std::string &path, const std::string &source_key) {
+    auto file = MappedFile::open(path);
+    if (file == nullptr) {
+        return nullptr;
+    }
+
+    Reader reader(file->data(), file->size());
+
+    FileHeader header{};
+    if (!reader.read(header) || std::memcmp(header.magic, VECTOR_SCENE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != VECTOR_SCENE_VERSION) {
+        return nullptr;
+    }
+
+    auto file_source_key = reader.read_bytes(header.source_key_size);
+    if (file_source_key == nullptr ||
+        std::string(file_source_key, file_source_key + header.source_key_size) != source_key) {
+        return nullptr;
+    }
+
+    auto scene = std::make_shared<Pathfinder::Scene>(0, read_rect(header.view_box));
+
+    for (uint32_t i = 0; i < header.paint_count; i++) {
+        uint8_t rgba[4];
+        if (!reader.read(rgba)) {
+            return nullptr;
+        }
+        // Paints were deduplicated when saving, so the IDs are kept.
+        if (scene->push_color_paint(ColorU(rgba[0], rgba[1], rgba[2], rgba[3])) != i) {
+            return nullptr;
+        }
+    }
+
+    uint32_t path_count = header.clip_path_count + header.draw_path_count;
+
+    for (uint32_t i = 0; i < path_count; i++) {
+        bool is_clip_path = i < header.clip_path_count;
+
+        PathHeader path_header{};
+        if (!reader.read(path_header)) {
+            return nullptr;
+        }
+
+        // Clip paths can only refer to clip paths defined before them.
+        auto clip_path_limit = is_clip_path ? i : header.clip_path_count;
+        if (path_header.clip_path >= (int32_t)clip_path_limit ||
+            path_header.fill_rule > (uint8_t)Pathfinder::FillRule::EvenOdd ||
+            path_header.blend_mode > (uint8_t)Pathfinder::BlendMode::Luminosity) {
+            return nullptr;
+        }
+
+        std::shared_ptr<uint32_t> clip_path;
+        if (path_header.clip_path >= 0) {
+            clip_path = std::make_shared<uint32_t>(path_header.clip_path);
+        }
+
+        if (is_clip_path) {
+            Pathfinder::ClipPath clip;
+            if (!read_outline(reader, path_header, scene->arena, clip.outline)) {
+                return nullptr;
+            }
+            clip.clip_path = clip_path;
+            clip.fill_rule = (Pathfinder::FillRule)path_header.fill_rule;
+            scene->push_clip_path(std::move(clip));
+        } else {
+            if (path_header.paint >= header.paint_count) {
+                return nullptr;
+            }
+
+            Pathfinder::DrawPath draw_path;
+            if (!read_outline(reader, path_header, scene->arena, draw_path.outline)) {
+                return nullptr;
+            }
+            draw_path.clip_path = clip_path;
+            draw_path.paint = path_header.paint;
+            draw_path.fill_rule = (Pathfinder::FillRule)path_header.fill_rule;
+            draw_path.blend_mode = (Pathfinder::BlendMode)path_header.blend_mode;
+            scene->push_draw_path(std::move(draw_path));
+        }
+    }
+
+    return std::make_shared<Pathfinder::SvgScene>(scene, Vec2F(header.size[0], header.size[1]));
+}
+
+} // namespace revector
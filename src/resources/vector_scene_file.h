@@ -0,0 +1,25 @@
+#pragma once
+
+#include <pathfinder/prelude.h>
+
+#include <memory>
+#include <string>
+
+namespace revector {
+
+/// Extension of the compact binary vector scene format.
+const std::string VECTOR_SCENE_FILE_EXTENSION = ".rvscene";
+
+/**
+ * Save a parsed SVG in a compact binary format (flattened contours and paints), which can be loaded without
+ * parsing. Only draw paths, clip paths and solid colors are supported, which is what SVGs without gradients produce.
+ * @param source_key Identifies what the scene was parsed from. Loading with another key fails.
+ * @return False if the scene is not supported or the file can't be written.
+ */
+bool save_vector_scene(const Pathfinder::SvgScene &svg_scene, const std::string &path, const std::string &source_key);
+
+/// Load a scene saved by save_vector_scene() from a memory-mapped file.
+/// Returns null if the file doesn't exist, is invalid, or has another source key.
+std::shared_ptr<Pathfinder::SvgScene> load_vector_scene(const std::string &path, const std::string &source_key);
+
+} // namespace revector
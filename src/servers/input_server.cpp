@@ -2,30 +2,11 @@
 
 #include <pathfinder/prelude.h>
 
-#include <codecvt>
-#include <locale>
-
 #include "../nodes/sub_window.h"
 #include "render_server.h"
 
 namespace revector {
 
-std::string cpp11_codepoint_to_utf8(char32_t codepoint) {
-    char utf8[4];
-    char *end_of_utf8;
-
-    char32_t const *from = &codepoint;
-
-    std::mbstate_t mbs;
-    std::codecvt_utf8<char32_t> ccv;
-
-    if (ccv.out(mbs, from, from + 1, from, utf8, utf8 + 4, end_of_utf8)) {
-        throw std::runtime_error("Bad codepoint-to-utf8 conversion!");
-    }
-
-    return {utf8, end_of_utf8};
-}
-
 void InputEvent::consume() {
     consumed = true;
 }
@@ -196,6 +177,62 @@ void InputServer::initialize_window_callbacks(uint8_t window_index) {
 
 void InputServer::clear_events() {
     input_queue.clear();
+    raw_input_queue.clear();
+}
+
+void InputServer::coalesce_events() {
+    if (!coalescing_enabled || input_queue.empty()) {
+        return;
+    }
+
+    raw_input_queue = std::move(input_queue);
+    input_queue.clear();
+    input_queue.reserve(raw_input_queue.size());
+
+    for (uint32_t i = 0; i < raw_input_queue.size(); i++) {
+        auto event = raw_input_queue[i];
+        event.raw_index = i;
+        event.raw_count = 1;
+
+        if (!input_queue.empty()) {
+            auto &last = input_queue.back();
+
+            // Only merge events that are next to each other, so the order relative to other events is preserved.
+            if (last.type == event.type && last.window_index == event.window_index) {
+                if (event.type == InputEventType::MouseMotion) {
+                    last.args.mouse_motion.relative += event.args.mouse_motion.relative;
+                    last.args.mouse_motion.position = event.args.mouse_motion.position;
+                    last.raw_count++;
+                    continue;
+                }
+                if (event.type == InputEventType::MouseScroll) {
+                    last.args.mouse_scroll.x_delta += event.args.mouse_scroll.x_delta;
+                    last.args.mouse_scroll.y_delta += event.args.mouse_scroll.y_delta;
+                    last.raw_count++;
+                    continue;
+                }
+            }
+        }
+
+        input_queue.push_back(event);
+    }
+}
+
+void InputServer::set_input_coalescing(bool enabled) {
+    coalescing_enabled = enabled;
+}
+
+bool InputServer::get_input_coalescing() const {
+    return coalescing_enabled;
+}
+
+std::vector<InputEvent> InputServer::get_raw_events(const InputEvent &event) const {
+    if (!coalescing_enabled || event.raw_index + event.raw_count > raw_input_queue.size()) {
+        return {event};
+    }
+
+    auto begin = raw_input_queue.begin() + event.raw_index;
+    return {begin, begin + event.raw_count};
 }
 
 std::string InputServer::get_clipboard(uint8_t window_index) {
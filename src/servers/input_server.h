@@ -75,19 +75,15 @@ public:
 
     bool is_consumed() const;
 
+    /// Range of the raw events this event was merged from, see InputServer::get_raw_events().
+    /// Only meaningful when input coalescing is enabled.
+    uint32_t raw_index = 0;
+    uint32_t raw_count = 1;
+
 private:
     bool consumed = false;
 };
 
-/// Unicode codepoint to UTF8 string.
-std::string cpp11_codepoint_to_utf8(char32_t codepoint);
-
-/// wstring to UTF8 string.
-std::string ws_to_utf8(std::wstring const &s);
-
-/// UTF8 string to wstring.
-std::wstring utf8_to_ws(std::string const &utf8);
-
 enum class CursorShape {
     // The regular arrow cursor.
     Arrow,
@@ -118,6 +114,18 @@ public:
 
     void clear_events();
 
+    /// Merge consecutive mouse motion and scroll events of the same window in the input queue.
+    /// Does nothing if input coalescing is disabled.
+    void coalesce_events();
+
+    void set_input_coalescing(bool enabled);
+
+    bool get_input_coalescing() const;
+
+    /// Get the raw (not coalesced) events an event in the input queue was merged from.
+    /// Useful for nodes that need every motion sample, e.g. drawing tools.
+    std::vector<InputEvent> get_raw_events(const InputEvent &event) const;
+
     std::string get_clipboard(uint8_t window_index);
     void set_clipboard(uint8_t window_index, std::string text);
 
@@ -126,6 +134,9 @@ public:
 
     std::vector<InputEvent> input_queue;
 
+    /// Events of this frame before coalescing.
+    std::vector<InputEvent> raw_input_queue;
+
     void set_cursor_captured(uint8_t window_index, bool captured);
 
     void hide_cursor(uint8_t window_index);
@@ -141,6 +152,8 @@ private:
     GLFWcursor *resize_tlbr_cursor, *resize_trbl_cursor;
 
     std::set<KeyCode> keys_pressed;
+
+    bool coalescing_enabled = false;
 };
 
 } // namespace revector
@@ -1,24 +1,224 @@
 #include "text_server.h"
 
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+
+#include "../resources/default_resource.h"
+
 namespace revector {
 
-void TextServer::load_font_from_file(const std::string& file_path) {
+namespace {
+
+/// The primary and the default fonts take two bits of the 32-bit masks.
+const size_t MAX_FALLBACK_FONT_COUNT = 30;
+
+/// Bounds the memory of coverage masks of fonts which are gone.
+const size_t MAX_COVERAGE_MASK_COUNT = 65536;
+
+} // namespace
+
+std::shared_ptr<Font> TextServer::load_font_from_file(const std::string &file_path) {
+    std::error_code error;
+    auto canonical_path = std::filesystem::weakly_canonical(file_path, error);
+    auto font_id = error ? file_path : canonical_path.string();
+
+    if (auto font = get_font(font_id)) {
+        return font;
+    }
+
+    // Load without holding the lock.
+    auto font = std::make_shared<Font>(font_id);
+    if (!font->is_valid()) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Another thread may have loaded it meanwhile.
+    auto &cached_font = font_cache[font_id];
+    if (auto existing_font = cached_font.lock()) {
+        return existing_font;
+    }
+    cached_font = font;
+
+    return font;
+}
+
+std::shared_ptr<Font> TextServer::load_font_from_memory(std::vector<char> bytes) {
+    auto hash = std::hash<std::string_view>()(std::string_view(bytes.data(), bytes.size()));
+    auto font_id = "memory:" + std::to_string(hash) + ":" + std::to_string(bytes.size());
+
+    if (auto font = get_font(font_id)) {
+        return font;
+    }
+
+    auto font = std::make_shared<Font>(std::move(bytes));
+    if (!font->is_valid()) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto &cached_font = font_cache[font_id];
+    if (auto existing_font = cached_font.lock()) {
+        return existing_font;
+    }
+    cached_font = font;
+
+    return font;
 }
 
-void TextServer::load_font_from_momery(const std::vector<char>& bytes) {
+std::shared_ptr<Font> TextServer::load_font_from_static_memory(const unsigned char *data, size_t size) {
+    auto font_id = "static:" + std::to_string(reinterpret_cast<uintptr_t>(data)) + ":" + std::to_string(size);
+
+    if (auto font = get_font(font_id)) {
+        return font;
+    }
+
+    auto font = std::make_shared<Font>(data, size, nullptr);
+    if (!font->is_valid()) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto &cached_font = font_cache[font_id];
+    if (auto existing_font = cached_font.lock()) {
+        return existing_font;
+    }
+    cached_font = font;
+
+    return font;
 }
 
-std::shared_ptr<std::vector<char>> TextServer::get_font(std::string font_id) {
-    auto find = raw_font_cache.find(font_id);
-    if (find != raw_font_cache.end()) {
-        return raw_font_cache[font_id];
+std::shared_ptr<Font> TextServer::get_font(const std::string &font_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto find = font_cache.find(font_id);
+    if (find == font_cache.end()) {
+        return nullptr;
     }
-    return nullptr;
+
+    auto font = find->second.lock();
+    if (!font) {
+        font_cache.erase(find);
+    }
+    return font;
+}
+
+void TextServer::set_fallback_fonts(std::vector<std::shared_ptr<Font>> fonts) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (fonts.size() > MAX_FALLBACK_FONT_COUNT) {
+        Logger::warn("Too many fallback fonts, only the first " + std::to_string(MAX_FALLBACK_FONT_COUNT) + " are used",
+                     "revector");
+        fonts.resize(MAX_FALLBACK_FONT_COUNT);
+    }
+
+    fallback_fonts = std::move(fonts);
+    coverage_masks.clear();
+}
+
+std::vector<std::shared_ptr<Font>> TextServer::get_fallback_fonts() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return fallback_fonts;
+}
+
+uint32_t TextServer::get_coverage_mask(Font *font, uint32_t codepoint, const std::vector<Font *> &chain) {
+    uint64_t key = (uint64_t)font->get_id() << 32 | codepoint;
+
+    auto cached_mask = coverage_masks.find(key);
+    if (cached_mask != coverage_masks.end()) {
+        return cached_mask->second;
+    }
+
+    uint32_t mask = 0;
+    for (size_t i = 0; i < chain.size(); i++) {
+        if (chain[i]->has_codepoint(codepoint)) {
+            mask |= 1u << i;
+        }
+    }
+
+    if (coverage_masks.size() >= MAX_COVERAGE_MASK_COUNT) {
+        coverage_masks.clear();
+    }
+    coverage_masks[key] = mask;
+
+    return mask;
+}
+
+Font *TextServer::resolve_font(Font *font, const std::u32string &codepoints) {
+    // Not under the lock, as creating the default resources loads the default font through this server.
+    auto default_font_ref = DefaultResource::get_singleton()->get_default_font();
+    auto default_font = default_font_ref.get();
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<Font *> chain = {font};
+    for (auto &fallback_font : fallback_fonts) {
+        chain.push_back(fallback_font.get());
+    }
+
+    if (std::find(chain.begin(), chain.end(), default_font) == chain.end()) {
+        chain.push_back(default_font);
+    }
+
+    // The masks depend on the default font too.
+    if (default_font->get_id() != coverage_default_font_id) {
+        coverage_masks.clear();
+        coverage_default_font_id = default_font->get_id();
+    }
+
+    uint32_t all_mask = UINT32_MAX;
+    uint32_t first_mask = 0;
+    bool first = true;
+
+    for (auto codepoint : codepoints) {
+        // Skip line breaks.
+        if (codepoint == 0x000A) {
+            continue;
+        }
+
+        auto mask = get_coverage_mask(font, codepoint, chain);
+        all_mask &= mask;
+
+        if (first) {
+            first_mask = mask;
+            first = false;
+        }
+
+        // No font has all of them, so only the first codepoint matters.
+        if (all_mask == 0) {
+            break;
+        }
+    }
+
+    auto mask = all_mask != 0 ? all_mask : first_mask;
+    if (mask == 0) {
+        return font;
+    }
+
+    // Lowest set bit.
+    uint32_t index = 0;
+    while (!(mask >> index & 1)) {
+        index++;
+    }
+
+    return chain[index];
 }
 
 void TextServer::cleanup() {
+    std::lock_guard<std::mutex> lock(mutex);
+
     font_cache.clear();
-    raw_font_cache.clear();
+    fallback_fonts.clear();
+    coverage_masks.clear();
+}
+
+std::shared_ptr<Font> ResourceFactory<Font>::create(const std::string &path) {
+    return TextServer::get_singleton()->load_font_from_file(path);
 }
 
 } // namespace revector
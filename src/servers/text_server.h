@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -7,23 +8,56 @@
 
 namespace revector {
 
+/// Registry of loaded fonts, so that every window and label shares the same faces.
 class TextServer {
 public:
-    void load_font_from_file(const std::string& file_path);
+    static TextServer *get_singleton() {
+        static TextServer singleton;
+        return &singleton;
+    }
 
-    void load_font_from_momery(const std::vector<char>& bytes);
+    /// Fonts are keyed by their canonical path. Returns null if the file can't be loaded.
+    std::shared_ptr<Font> load_font_from_file(const std::string &file_path);
 
-    std::shared_ptr<std::vector<char>> get_font(std::string font_id);
+    /// Fonts are keyed by a hash of their bytes.
+    std::shared_ptr<Font> load_font_from_memory(std::vector<char> bytes);
+
+    /// For data outliving the server (e.g. embedded fonts), which is used in place. Fonts are keyed by address.
+    std::shared_ptr<Font> load_font_from_static_memory(const unsigned char *data, size_t size);
+
+    /// Returns null if no font with the ID (canonical path or content key) is loaded.
+    std::shared_ptr<Font> get_font(const std::string &font_id);
+
+    /// Fonts tried in order for text a font has no glyphs for. The default font is tried last.
+    void set_fallback_fonts(std::vector<std::shared_ptr<Font>> fonts);
+
+    std::vector<std::shared_ptr<Font>> get_fallback_fonts();
+
+    /// The first of `font` and the fallback fonts which has all the codepoints (line breaks aside).
+    /// If none has them all, the first font having the first codepoint, or else `font`.
+    Font *resolve_font(Font *font, const std::u32string &codepoints);
 
     void cleanup();
 
 private:
+    /// Bit i is set if font i of [font, fallback fonts..., default font] has the codepoint.
+    uint32_t get_coverage_mask(Font *font, uint32_t codepoint, const std::vector<Font *> &chain);
+
     std::string clipboard;
 
-    // Cache for raw font data.
-    std::unordered_map<std::string, std::shared_ptr<std::vector<char>>> raw_font_cache;
+    /// Fonts are unloaded once unused, so this only holds weak references.
+    std::unordered_map<std::string, std::weak_ptr<Font>> font_cache;
+
+    std::vector<std::shared_ptr<Font>> fallback_fonts;
+
+    /// Coverage masks keyed by font ID and codepoint, so that resolving a run takes one lookup per codepoint.
+    /// Dropped when the fallback fonts change.
+    std::unordered_map<uint64_t, uint32_t> coverage_masks;
+
+    uint32_t coverage_default_font_id = 0;
 
-    std::unordered_map<std::string, std::shared_ptr<Font>> font_cache;
+    /// Fonts can be loaded from worker threads (see ResourceManager::load_async()).
+    std::mutex mutex;
 };
 
 } // namespace revector
@@ -1,5 +1,6 @@
 #include "vector_server.h"
 
+#include "../resources/vector_scene_file.h"
 #include "debug_server.h"
 
 namespace revector {
@@ -13,9 +14,15 @@ void VectorServer::init(Pathfinder::Vec2I size,
     canvas = std::make_shared<Pathfinder::Canvas>(size, device, queue, level);
 
     reset_render_layers();
+
+    composite_scene = std::make_shared<Pathfinder::Scene>(0, RectF({}, size.to_f32()));
 }
 
 void VectorServer::cleanup() {
+    layer_caches.clear();
+    svg_cache.clear();
+    emoji_scenes.clear();
+    composite_scene.reset();
     canvas.reset();
 }
 
@@ -32,14 +39,166 @@ void VectorServer::set_dst_texture(const std::shared_ptr<Pathfinder::Texture> &t
 }
 
 void VectorServer::submit_and_clear() {
+    auto dst_texture = canvas->get_dst_texture();
+    if (!dst_texture) {
+        reset_render_layers();
+        return;
+    }
+
+    auto &cache = get_layer_cache(dst_texture);
+
+    std::array<bool, MAX_RENDER_LAYER> changed_layers{};
+    bool any_changed = false;
+
     for (uint8_t i = 0; i < MAX_RENDER_LAYER; i++) {
-        canvas->set_scene(render_layers[i]);
-        canvas->draw(i == 0);
+        auto scene_hash = render_layers[i]->is_empty() ? 0 : render_layers[i]->compute_hash();
+
+        changed_layers[i] = invalidated_layers[i] || scene_hash != cache.scene_hashes[i];
+        any_changed |= changed_layers[i];
+
+        cache.scene_hashes[i] = scene_hash;
+    }
+
+    if (!any_changed) {
+        reset_render_layers();
+        return;
+    }
+
+    if (layer_caching) {
+        composite_scene->clear();
+        composite_scene->set_view_box(RectF({}, dst_texture->get_size().to_f32()));
+
+        for (uint8_t i = 0; i < MAX_RENDER_LAYER; i++) {
+            auto &texture = cache.textures[i];
+
+            if (render_layers[i]->is_empty()) {
+                texture.reset();
+                continue;
+            }
+
+            if (texture && texture->get_size() != dst_texture->get_size()) {
+                texture.reset();
+            }
+
+            if (!texture) {
+                texture = RenderServer::get_singleton()->device_->create_texture(
+                    {dst_texture->get_size(), Pathfinder::TextureFormat::Rgba8Unorm}, "layer texture");
+                changed_layers[i] = true;
+            }
+
+            if (changed_layers[i]) {
+                render_scene_to_texture(render_layers[i], texture);
+            }
+
+            canvas->set_scene(composite_scene);
+            canvas->draw_raw_texture(texture, RectF({}, dst_texture->get_size().to_f32()));
+        }
+
+        canvas->set_scene(composite_scene);
+        canvas->draw(true);
+    } else {
+        bool cleared = false;
+
+        for (uint8_t i = 0; i < MAX_RENDER_LAYER; i++) {
+            // The first layer always clears the destination texture, even if it's empty.
+            if (cleared && render_layers[i]->is_empty()) {
+                continue;
+            }
+
+            canvas->set_scene(render_layers[i]);
+            canvas->draw(!cleared);
+            cleared = true;
+        }
     }
 
     reset_render_layers();
 }
 
+void VectorServer::set_layer_caching(bool enabled) {
+    layer_caching = enabled;
+
+    for (auto &cache : layer_caches) {
+        cache.textures = {};
+        // Make sure the next submission draws.
+        cache.scene_hashes.fill(1);
+    }
+}
+
+bool VectorServer::get_layer_caching() const {
+    return layer_caching;
+}
+
+void VectorServer::invalidate_layer(uint8_t layer_id) {
+    if (layer_id >= MAX_RENDER_LAYER) {
+        return;
+    }
+
+    invalidated_layers[layer_id] = true;
+}
+
+void VectorServer::invalidate_current_layer() {
+    auto scene = recording_stack.empty() ? canvas->get_scene() : recording_stack.front();
+
+    for (uint8_t i = 0; i < MAX_RENDER_LAYER; i++) {
+        if (render_layers[i] == scene) {
+            invalidated_layers[i] = true;
+            return;
+        }
+    }
+}
+
+VectorServer::LayerCache &VectorServer::get_layer_cache(const std::shared_ptr<Pathfinder::Texture> &dst_texture) {
+    // Drop caches of destroyed textures, e.g. after a window is resized.
+    layer_caches.erase(std::remove_if(layer_caches.begin(),
+                                      layer_caches.end(),
+                                      [](const LayerCache &cache) { return cache.dst_texture.expired(); }),
+                       layer_caches.end());
+
+    for (auto &cache : layer_caches) {
+        if (cache.dst_texture.lock() == dst_texture) {
+            return cache;
+        }
+    }
+
+    auto &cache = layer_caches.emplace_back();
+    cache.dst_texture = dst_texture;
+    // Make sure the first submission draws.
+    cache.scene_hashes.fill(1);
+
+    return cache;
+}
+
+std::shared_ptr<Pathfinder::Scene> VectorServer::get_emoji_scene(Font &font, uint16_t glyph_index) {
+    uint64_t key = (uint64_t)font.get_id() << 16 | glyph_index;
+
+    auto iter = emoji_scenes.find(key);
+    if (iter != emoji_scenes.end()) {
+        return iter->second;
+    }
+
+    std::shared_ptr<Pathfinder::Scene> scene;
+
+    auto svg = font.get_glyph_svg(glyph_index);
+    if (!svg.empty()) {
+        Pathfinder::SvgScene svg_scene(svg, *canvas);
+
+        // The emoji's svg size is always fixed for a specific font no matter what the font size you set.
+        auto svg_size = svg_scene.get_size();
+
+        if (svg_scene.get_scene() && svg_size.area() > 0) {
+            scene = std::make_shared<Pathfinder::Scene>(0, RectF({}, Vec2F(1)));
+            scene->append_scene(*svg_scene.get_scene(), Transform2::from_scale(Vec2F(1) / svg_size));
+        }
+    }
+
+    if (emoji_scenes.size() >= MAX_CACHED_EMOJI_SCENES) {
+        emoji_scenes.clear();
+    }
+    emoji_scenes[key] = scene;
+
+    return scene;
+}
+
 std::shared_ptr<Pathfinder::Canvas> VectorServer::get_canvas() const {
     return canvas;
 }
@@ -58,26 +217,111 @@ void VectorServer::set_render_layer(uint8_t layer_id) {
         return;
     }
 
+    if (is_recording()) {
+        return;
+    }
+
     canvas->set_scene(render_layers[layer_id]);
 }
 
+void VectorServer::push_scene(const std::shared_ptr<Pathfinder::Scene> &scene) {
+    recording_stack.push_back(canvas->get_scene());
+
+    scene->clear();
+    canvas->set_scene(scene);
+}
+
+void VectorServer::pop_scene() {
+    if (recording_stack.empty()) {
+        Logger::error("Unbalanced scene pop!", "revector");
+        return;
+    }
+
+    canvas->set_scene(recording_stack.back());
+    recording_stack.pop_back();
+}
+
+bool VectorServer::is_recording() const {
+    return !recording_stack.empty();
+}
+
+void VectorServer::render_scene_to_texture(const std::shared_ptr<Pathfinder::Scene> &scene,
+                                           const std::shared_ptr<Pathfinder::Texture> &texture) {
+    // The layer drawing the texture doesn't know its content has changed.
+    invalidate_current_layer();
+
+    auto previous_scene = canvas->get_scene();
+    auto previous_dst_texture = canvas->get_dst_texture();
+
+    canvas->set_dst_texture(texture);
+    canvas->set_scene(scene);
+    canvas->draw(true);
+
+    // There's no destination texture before the first frame is submitted.
+    if (previous_dst_texture) {
+        canvas->set_dst_texture(previous_dst_texture);
+    }
+    canvas->set_scene(previous_scene);
+}
+
+void VectorServer::push_clip_rect(const RectF &rect, bool intersect) {
+    if (clip_rect_stack.empty() || !intersect) {
+        clip_rect_stack.push_back(rect);
+        return;
+    }
+
+    auto &current = clip_rect_stack.back();
+
+    if (current.is_valid() && current.intersects(rect)) {
+        clip_rect_stack.push_back(current.intersection(rect));
+    } else {
+        clip_rect_stack.emplace_back(0.f, 0.f, -1.f, -1.f);
+    }
+}
+
+void VectorServer::pop_clip_rect() {
+    if (clip_rect_stack.empty()) {
+        Logger::error("Unbalanced clip rect pop!", "revector");
+        return;
+    }
+
+    clip_rect_stack.pop_back();
+}
+
+bool VectorServer::is_rect_visible(const RectF &rect) const {
+    if (clip_rect_stack.empty()) {
+        return true;
+    }
+
+    auto &current = clip_rect_stack.back();
+
+    return current.is_valid() && current.intersects(rect);
+}
+
 void VectorServer::reset_render_layers() {
+    // Layers are reused, keeping their memory.
     for (uint8_t i = 0; i < MAX_RENDER_LAYER; i++) {
-        render_layers[i] = std::make_shared<Pathfinder::Scene>(i, RectF({}, canvas->get_size().to_f32()));
+        if (render_layers[i]) {
+            render_layers[i]->clear();
+        } else {
+            render_layers[i] = std::make_shared<Pathfinder::Scene>(i, RectF({}, canvas->get_size().to_f32()));
+        }
     }
     canvas->set_scene(render_layers[0]);
+
+    invalidated_layers = {};
 }
 
 void VectorServer::draw_line(Vec2F start, Vec2F end, float width, ColorU color) {
     canvas->save_state();
 
-    Pathfinder::Path2d path;
+    auto path = canvas->create_path();
     path.add_line({start.x, start.y}, {end.x, end.y});
 
-    canvas->set_stroke_paint(Pathfinder::Paint::from_color(color));
+    canvas->set_stroke_color(color);
     canvas->set_line_width(width);
     // canvas->set_line_cap(Pathfinder::LineCap::Round);
-    canvas->stroke_path(path);
+    canvas->stroke_path(std::move(path));
 
     canvas->restore_state();
 }
@@ -85,18 +329,18 @@ void VectorServer::draw_line(Vec2F start, Vec2F end, float width, ColorU color)
 void VectorServer::draw_rectangle(const RectF &rect, float line_width, ColorU color, bool fill) {
     canvas->save_state();
 
-    Pathfinder::Path2d path;
+    auto path = canvas->create_path();
     path.add_rect(rect);
 
     canvas->set_transform(Pathfinder::Transform2::from_scale(Vec2F(global_scale_, global_scale_)));
 
     if (fill) {
-        canvas->set_fill_paint(Pathfinder::Paint::from_color(color));
-        canvas->fill_path(path, Pathfinder::FillRule::Winding);
+        canvas->set_fill_color(color);
+        canvas->fill_path(std::move(path), Pathfinder::FillRule::Winding);
     } else {
-        canvas->set_stroke_paint(Pathfinder::Paint::from_color(color));
+        canvas->set_stroke_color(color);
         canvas->set_line_width(line_width);
-        canvas->stroke_path(path);
+        canvas->stroke_path(std::move(path));
     }
 
     canvas->restore_state();
@@ -105,16 +349,16 @@ void VectorServer::draw_rectangle(const RectF &rect, float line_width, ColorU co
 void VectorServer::draw_circle(Vec2F center, float radius, float line_width, bool fill, ColorU color) {
     canvas->save_state();
 
-    Pathfinder::Path2d path;
+    auto path = canvas->create_path();
     path.add_circle({center.x, center.y}, radius);
 
     if (fill) {
-        canvas->set_fill_paint(Pathfinder::Paint::from_color(color));
-        canvas->fill_path(path, Pathfinder::FillRule::Winding);
+        canvas->set_fill_color(color);
+        canvas->fill_path(std::move(path), Pathfinder::FillRule::Winding);
     } else if (line_width > 0) {
-        canvas->set_stroke_paint(Pathfinder::Paint::from_color(color));
+        canvas->set_stroke_color(color);
         canvas->set_line_width(line_width);
-        canvas->stroke_path(path);
+        canvas->stroke_path(std::move(path));
     }
 
     canvas->restore_state();
@@ -128,12 +372,12 @@ void VectorServer::draw_path(VectorPath &vector_path, Transform2 transform) {
     canvas->set_transform(dpi_scaling_xform * global_transform_offset * transform);
 
     if (vector_path.fill_color.is_opaque()) {
-        canvas->set_fill_paint(Pathfinder::Paint::from_color(vector_path.fill_color));
+        canvas->set_fill_color(vector_path.fill_color);
         canvas->fill_path(vector_path.path2d, Pathfinder::FillRule::Winding);
     }
 
     if (vector_path.stroke_width > 0) {
-        canvas->set_stroke_paint(Pathfinder::Paint::from_color(vector_path.stroke_color));
+        canvas->set_stroke_color(vector_path.stroke_color);
         canvas->set_line_width(vector_path.stroke_width);
         canvas->stroke_path(vector_path.path2d);
     }
@@ -146,11 +390,53 @@ void VectorServer::draw_raster_image(RasterImage &image, Transform2 transform) {
 
     auto dpi_scaling_xform = Pathfinder::Transform2::from_scale(Vec2F(global_scale_, global_scale_));
 
-    canvas->set_transform(dpi_scaling_xform * global_transform_offset * transform);
+    auto screen_transform = dpi_scaling_xform * global_transform_offset * transform;
+    canvas->set_transform(screen_transform);
+
+    auto image_size = image.image_data->size.to_f32();
+
+    // Pick the mip level by the larger axis scale, so that no axis is undersampled.
+    auto screen_scale = std::max(Vec2F(screen_transform.m11(), screen_transform.m21()).length(),
+                                 Vec2F(screen_transform.m12(), screen_transform.m22()).length());
 
-    auto image_data = image.image_data;
+    auto level = image.select_mip_level(screen_scale);
+    auto mip = image.get_mip_level(level);
+
+    if (mip->size.x <= (int32_t)Pathfinder::ATLAS_TEXTURE_LENGTH &&
+        mip->size.y <= (int32_t)Pathfinder::ATLAS_TEXTURE_LENGTH) {
+        canvas->draw_image(mip, RectF({}, image_size));
+    } else {
+        // Only draw (and thereby upload) tiles within the current clip rect and the canvas.
+        auto mip_to_image = image_size / mip->size.to_f32();
+        auto screen_rect = RectF({}, canvas->get_size().to_f32());
+        auto tile_count = (mip->size + (RASTER_IMAGE_TILE_LENGTH - 1)) / RASTER_IMAGE_TILE_LENGTH;
+
+        size_t visible_tile_count = 0;
+
+        for (int32_t y = 0; y < tile_count.y; y++) {
+            for (int32_t x = 0; x < tile_count.x; x++) {
+                auto tile_origin = Vec2I(x, y) * RASTER_IMAGE_TILE_LENGTH;
+                auto tile_rect = RectI(tile_origin, tile_origin + RASTER_IMAGE_TILE_LENGTH)
+                                     .intersection(RectI({}, mip->size))
+                                     .to_f32();
+                auto dst_rect = RectF(tile_rect.origin() * mip_to_image, tile_rect.lower_right() * mip_to_image);
+
+                if (!is_rect_visible(transform * dst_rect) || !(screen_transform * dst_rect).intersects(screen_rect)) {
+                    continue;
+                }
+
+                auto &tile = image.get_tile(level, {x, y});
+                auto src_rect = RectI(tile.rect.origin() - tile.origin, tile.rect.lower_right() - tile.origin);
+
+                canvas->draw_subimage(tile.image, src_rect.to_f32(), dst_rect);
+
+                visible_tile_count++;
+            }
+        }
 
-    canvas->draw_image(image_data, RectF({}, Vec2F() + image_data->size.to_f32()));
+        // Keep some tiles around the visible ones for panning, drawn tiles are held by the scene anyway.
+        image.trim_tiles(visible_tile_count * 2);
+    }
 
     canvas->restore_state();
 }
@@ -163,12 +449,15 @@ void VectorServer::draw_vector_image(VectorImage &image, Transform2 transform) {
     }
 
     if (image.get_svg_scene()) {
-        canvas->get_scene()->append_scene(*image.get_svg_scene()->get_scene(),
-                                          dpi_scaling_xform * global_transform_offset * transform);
+        canvas->get_scene()->push_scene_instance(image.get_svg_scene()->get_scene(),
+                                                 dpi_scaling_xform * global_transform_offset * transform);
     }
 }
 
 void VectorServer::draw_render_image(RenderImage &render_image, Transform2 transform) {
+    // Render images are usually updated by the user every frame.
+    invalidate_current_layer();
+
     canvas->save_state();
 
     auto dpi_scaling_xform = Pathfinder::Transform2::from_scale(Vec2F(global_scale_, global_scale_));
@@ -181,7 +470,7 @@ void VectorServer::draw_render_image(RenderImage &render_image, Transform2 trans
 }
 
 void VectorServer::draw_style_box(const StyleBox &style_box, const Vec2F &position, const Vec2F &size, float alpha) {
-    auto path = Pathfinder::Path2d();
+    auto path = canvas->create_path();
     if (style_box.corner_radii.has_value()) {
         path.add_rect_with_corners({{}, size}, style_box.corner_radii.value());
     } else {
@@ -198,20 +487,24 @@ void VectorServer::draw_style_box(const StyleBox &style_box, const Vec2F &positi
     auto transform = Pathfinder::Transform2::from_translation(position);
     canvas->set_transform(dpi_scaling_xform * global_transform_offset * transform);
 
-    canvas->set_fill_paint(Pathfinder::Paint::from_color(style_box.bg_color.apply_alpha(alpha)));
-    canvas->fill_path(path, Pathfinder::FillRule::Winding);
+    canvas->set_fill_color(style_box.bg_color.apply_alpha(alpha));
 
+    // The path is only copied if it's needed again for the border.
     if (style_box.border_width > 0) {
-        canvas->set_stroke_paint(Pathfinder::Paint::from_color(style_box.border_color.apply_alpha(alpha)));
+        canvas->fill_path(path, Pathfinder::FillRule::Winding);
+
+        canvas->set_stroke_color(style_box.border_color.apply_alpha(alpha));
         canvas->set_line_width(style_box.border_width);
-        canvas->stroke_path(path);
+        canvas->stroke_path(std::move(path));
+    } else {
+        canvas->fill_path(std::move(path), Pathfinder::FillRule::Winding);
     }
 
     canvas->restore_state();
 }
 
 void VectorServer::draw_style_line(const StyleLine &style_line, const Vec2F &start, const Vec2F &end) {
-    auto path = Pathfinder::Path2d();
+    auto path = canvas->create_path();
     path.add_line(start, end);
 
     canvas->save_state();
@@ -219,15 +512,15 @@ void VectorServer::draw_style_line(const StyleLine &style_line, const Vec2F &sta
     auto dpi_scaling_xform = Pathfinder::Transform2::from_scale(Vec2F(global_scale_, global_scale_));
 
     canvas->set_transform(dpi_scaling_xform * global_transform_offset);
-    canvas->set_stroke_paint(Pathfinder::Paint::from_color(style_line.color));
+    canvas->set_stroke_color(style_line.color);
     canvas->set_line_width(style_line.width);
-    canvas->stroke_path(path);
+    canvas->stroke_path(std::move(path));
 
     canvas->restore_state();
 }
 
-void VectorServer::draw_glyphs(std::vector<Glyph> &glyphs,
-                               std::vector<Vec2F> &glyph_positions,
+void VectorServer::draw_glyphs(const GlyphRun &glyphs,
+                               const std::vector<Vec2F> &glyph_positions,
                                TextStyle text_style,
                                const Transform2 &transform,
                                const RectF &clip_box,
@@ -240,16 +533,32 @@ void VectorServer::draw_glyphs(std::vector<Glyph> &glyphs,
     text_style.color = text_style.color.apply_alpha(alpha);
     text_style.stroke_color = text_style.stroke_color.apply_alpha(alpha);
 
+    // Emojis are drawn from scenes, and other glyphs from outlines.
+    std::vector<std::shared_ptr<Pathfinder::Scene>> glyph_emoji_scenes(glyphs.size());
+    std::vector<std::shared_ptr<const GlyphOutline>> glyph_outlines(glyphs.size());
+    for (size_t i = 0; i < glyphs.size(); i++) {
+        if (glyphs.has_flag(i, GLYPH_FLAG_SKIP_DRAWING)) {
+            continue;
+        }
+
+        const auto &face = glyphs.get_face(i);
+        if (glyphs.has_flag(i, GLYPH_FLAG_EMOJI)) {
+            glyph_emoji_scenes[i] = get_emoji_scene(*face.font, glyphs.indices[i]);
+        } else {
+            glyph_outlines[i] = face.font->get_glyph_outline(glyphs.indices[i], face.font_size);
+        }
+    }
+
     canvas->save_state();
 
     auto dpi_scaling_xform = Pathfinder::Transform2::from_scale(Vec2F(global_scale_, global_scale_));
 
     // Text clip.
     if (clip_box.is_valid()) {
-        auto clip_path = Pathfinder::Path2d();
+        auto clip_path = canvas->create_path();
         clip_path.add_rect(clip_box, 0);
         canvas->set_transform(dpi_scaling_xform * global_transform_offset * transform);
-        canvas->clip_path(clip_path, Pathfinder::FillRule::Winding);
+        canvas->clip_path(std::move(clip_path), Pathfinder::FillRule::Winding);
     }
 
     auto skew_xform = Transform2::from_scale({1, 1});
@@ -258,15 +567,14 @@ void VectorServer::draw_glyphs(std::vector<Glyph> &glyphs,
     }
 
     // Draw glyph strokes. The strokes go below the fills.
-    for (int i = 0; i < glyphs.size(); i++) {
-        auto &g = glyphs[i];
+    for (size_t i = 0; i < glyphs.size(); i++) {
         auto &p = glyph_positions[i];
 
-        if (g.emoji || g.skip_drawing) {
+        if (!glyph_outlines[i]) {
             continue;
         }
 
-        auto baseline_xform = Transform2::from_translation({0, g.ascent});
+        auto baseline_xform = Transform2::from_translation({0, glyphs.get_face(i).ascent});
 
         auto glyph_global_transform =
             dpi_scaling_xform * global_transform_offset * Transform2::from_translation(p) * transform * baseline_xform;
@@ -274,55 +582,55 @@ void VectorServer::draw_glyphs(std::vector<Glyph> &glyphs,
         canvas->set_transform(glyph_global_transform * skew_xform);
 
         // Add stroke if needed.
-        canvas->set_stroke_paint(Pathfinder::Paint::from_color(text_style.stroke_color));
+        canvas->set_stroke_color(text_style.stroke_color);
         float stroke_width = text_style.stroke_width;
         if (text_style.bold) {
             stroke_width += STROKE_WIDTH_FOR_PSEUDO_BOLD_TEXT;
         }
         canvas->set_line_width(stroke_width);
         canvas->set_line_join(Pathfinder::LineJoin::Round);
-        canvas->stroke_path(g.path);
+        // Outlines are shared, so draw copies.
+        canvas->stroke_path(Pathfinder::Path2d(glyph_outlines[i]->path, &canvas->get_scene()->arena));
     }
 
     // Draw glyph fills.
-    for (int i = 0; i < glyphs.size(); i++) {
-        auto &g = glyphs[i];
+    for (size_t i = 0; i < glyphs.size(); i++) {
         auto &p = glyph_positions[i];
 
-        if (g.skip_drawing) {
+        if (glyphs.has_flag(i, GLYPH_FLAG_SKIP_DRAWING)) {
             continue;
         }
 
-        auto baseline_xform = Transform2::from_translation({0, g.ascent});
+        auto baseline_xform = Transform2::from_translation({0, glyphs.get_face(i).ascent});
 
         // No italic for emojis and debug boxes.
         auto glyph_global_transform =
             dpi_scaling_xform * global_transform_offset * Transform2::from_translation(p) * transform * baseline_xform;
 
-        if (!g.emoji) {
+        if (glyph_outlines[i]) {
             canvas->set_transform(glyph_global_transform * skew_xform);
 
             // Add fill.
-            canvas->set_fill_paint(Pathfinder::Paint::from_color(text_style.color));
-            canvas->fill_path(g.path, Pathfinder::FillRule::Winding);
+            canvas->set_fill_color(text_style.color);
+            // Outlines are shared, so draw a copy.
+            auto path = Pathfinder::Path2d(glyph_outlines[i]->path, &canvas->get_scene()->arena);
 
             // Use stroke to make a pseudo bold effect.
             if (text_style.bold) {
-                canvas->set_stroke_paint(Pathfinder::Paint::from_color(text_style.color));
+                canvas->fill_path(path, Pathfinder::FillRule::Winding);
+
+                canvas->set_stroke_color(text_style.color);
                 canvas->set_line_width(STROKE_WIDTH_FOR_PSEUDO_BOLD_TEXT);
                 canvas->set_line_join(Pathfinder::LineJoin::Bevel);
-                canvas->stroke_path(g.path);
+                canvas->stroke_path(std::move(path));
+            } else {
+                canvas->fill_path(std::move(path), Pathfinder::FillRule::Winding);
             }
-        } else {
-            auto svg_scene = std::make_shared<Pathfinder::SvgScene>(g.svg, *canvas);
-
-            // The emoji's svg size is always fixed for a specific font no matter what the font size you set.
-            auto svg_size = svg_scene->get_size();
-            auto glyph_size = g.box.size();
-
-            auto emoji_scale = Transform2::from_scale(glyph_size / svg_size);
+        } else if (glyph_emoji_scenes[i]) {
+            // Emoji scenes are of unit size.
+            auto emoji_scale = Transform2::from_scale(glyphs.get_box(i).size());
 
-            canvas->get_scene()->append_scene(*(svg_scene->get_scene()), glyph_global_transform * emoji_scale);
+            canvas->get_scene()->push_scene_instance(glyph_emoji_scenes[i], glyph_global_transform * emoji_scale);
         }
 
         if (text_style.debug) {
@@ -331,20 +639,22 @@ void VectorServer::draw_glyphs(std::vector<Glyph> &glyphs,
 
             // Add box.
             // --------------------------------
-            Pathfinder::Path2d layout_path;
-            layout_path.add_rect(g.box);
+            auto layout_path = canvas->create_path();
+            layout_path.add_rect(glyphs.get_box(i));
 
-            canvas->set_stroke_paint(Pathfinder::Paint::from_color(ColorU::green()));
-            canvas->stroke_path(layout_path);
+            canvas->set_stroke_color(ColorU::green());
+            canvas->stroke_path(std::move(layout_path));
             // --------------------------------
 
             // Add bbox.
             // --------------------------------
-            Pathfinder::Path2d bbox_path;
-            bbox_path.add_rect(g.bbox);
+            if (glyph_outlines[i]) {
+                auto bbox_path = canvas->create_path();
+                bbox_path.add_rect(glyph_outlines[i]->bbox);
 
-            canvas->set_stroke_paint(Pathfinder::Paint::from_color(ColorU::red()));
-            canvas->stroke_path(bbox_path);
+                canvas->set_stroke_color(ColorU::red());
+                canvas->stroke_path(std::move(bbox_path));
+            }
             // --------------------------------
         }
     }
@@ -353,11 +663,76 @@ void VectorServer::draw_glyphs(std::vector<Glyph> &glyphs,
 }
 
 std::shared_ptr<Pathfinder::SvgScene> VectorServer::load_svg(const std::string &path) {
-    auto bytes = Pathfinder::load_file_as_string(path);
+    auto extension = VECTOR_SCENE_FILE_EXTENSION;
+    if (path.size() > extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0) {
+        // Converted offline, so there's no source to check.
+        auto svg_scene = load_vector_scene(path, "");
+        if (svg_scene == nullptr) {
+            Logger::error("Failed to load vector scene file " + path, "revector");
+            svg_scene = std::make_shared<Pathfinder::SvgScene>(nullptr, Vec2F());
+        }
+        return svg_scene;
+    }
 
-    auto svg_scene = std::make_shared<Pathfinder::SvgScene>(bytes, *canvas);
+    // Files that can't be stat-ed (e.g. Android assets) are parsed every time.
+    std::error_code error;
+    auto modified_time = std::filesystem::last_write_time(path, error);
+    auto file_size = error ? 0 : std::filesystem::file_size(path, error);
+    bool cacheable = !error;
+
+    if (cacheable) {
+        auto iter = svg_cache.find(path);
+        if (iter != svg_cache.end() && iter->second.modified_time == modified_time) {
+            return iter->second.svg_scene;
+        }
+    }
+
+    std::shared_ptr<Pathfinder::SvgScene> svg_scene;
+
+    // Binary files are named by a hash of their source, which is also checked when loading.
+    std::string binary_path, source_key;
+    if (cacheable && !svg_cache_dir.empty()) {
+        source_key = std::filesystem::absolute(path, error).string() + ":" +
+                     std::to_string(modified_time.time_since_epoch().count()) + ":" + std::to_string(file_size);
+
+        binary_path = (std::filesystem::path(svg_cache_dir) / (std::to_string(std::hash<std::string>()(source_key)) +
+                                                               VECTOR_SCENE_FILE_EXTENSION))
+                          .string();
+
+        svg_scene = load_vector_scene(binary_path, source_key);
+    }
+
+    if (svg_scene == nullptr) {
+        auto bytes = Pathfinder::load_file_as_string(path);
+
+        svg_scene = std::make_shared<Pathfinder::SvgScene>(bytes, *canvas);
+
+        if (!binary_path.empty()) {
+            save_vector_scene(*svg_scene, binary_path, source_key);
+        }
+    }
+
+    if (cacheable) {
+        svg_cache[path] = {modified_time, svg_scene};
+    }
 
     return svg_scene;
 }
 
+void VectorServer::set_svg_cache_dir(const std::string &dir) {
+    svg_cache_dir = dir;
+
+    if (svg_cache_dir.empty()) {
+        return;
+    }
+
+    // Cached files are loaded instead of the SVGs, so other users must not be able to write them.
+    std::error_code error;
+    std::filesystem::create_directories(svg_cache_dir, error);
+    std::filesystem::permissions(svg_cache_dir, std::filesystem::perms::owner_all, error);
+    if (error) {
+        Logger::warn("Failed to restrict the permissions of the SVG cache directory " + svg_cache_dir, "revector");
+    }
+}
+
 } // namespace revector
@@ -2,6 +2,8 @@
 
 #include <pathfinder/prelude.h>
 
+#include <filesystem>
+
 #include "../common/geometry.h"
 #include "../resources/font.h"
 #include "../resources/raster_image.h"
@@ -13,6 +15,9 @@ namespace revector {
 
 constexpr int MAX_RENDER_LAYER = 8;
 
+/// The emoji cache is dropped as a whole when it grows beyond this.
+constexpr int MAX_CACHED_EMOJI_SCENES = 1024;
+
 /**
  * All visible shapes will be collected by the vector server and drawn at once.
  */
@@ -36,8 +41,21 @@ public:
 
     void set_canvas_size(Vec2I new_size);
 
+    /// Draw all render layers onto the destination texture and clear them for the next frame.
+    /// Empty layers are skipped, and nothing is drawn if no layer has changed since the last submission
+    /// to the same destination texture.
     void submit_and_clear();
 
+    /// Render each layer into its own cached texture, which are composited onto the destination texture.
+    /// Only changed layers are re-rendered, e.g. opening a popup on layer 1 doesn't re-render layer 0.
+    /// This costs an extra compositing pass when anything changes, so it's disabled by default.
+    void set_layer_caching(bool enabled);
+
+    bool get_layer_caching() const;
+
+    /// Force a layer to be redrawn, e.g. after the content of a texture drawn on it has changed.
+    void invalidate_layer(uint8_t layer_id);
+
     void draw_line(Vec2F start, Vec2F end, float width, ColorU color);
 
     void draw_rectangle(const RectF &rect, float line_width, ColorU color, bool fill);
@@ -65,35 +83,117 @@ public:
      * We shouldn't use clip path to achieve general content clip (like scrolling)
      * since it's quite performance heavy and easily produces nested clipping.
      */
-    void draw_glyphs(std::vector<Glyph> &glyphs,
-                     std::vector<Vec2F> &glyph_positions,
+    void draw_glyphs(const GlyphRun &glyphs,
+                     const std::vector<Vec2F> &glyph_positions,
                      TextStyle text_style,
                      const Transform2 &transform,
                      const RectF &clip_box,
                      float alpha = 1.0f);
 
+    /// Load a SVG file, or a file in the binary vector scene format (see vector_scene_file.h).
+    /// Parsed SVGs are cached by path and modification time. If an SVG cache directory is set, they are also
+    /// converted to the binary format there on the first load, so that later runs don't need to parse them.
     std::shared_ptr<Pathfinder::SvgScene> load_svg(const std::string &path);
 
+    /// Where to keep the binary versions of loaded SVGs. Empty (the default) disables this.
+    /// Use a per-user directory (e.g. in the user's cache directory), as the files in it are trusted.
+    /// It's created if needed and made accessible to the owner only.
+    void set_svg_cache_dir(const std::string &dir);
+
     std::shared_ptr<Pathfinder::Canvas> get_canvas() const;
 
     float get_global_scale() const;
 
     void set_global_scale(float new_scale);
 
+    /// Ignored while recording a scene.
     void set_render_layer(uint8_t layer_id);
 
+    /// Record all drawing afterward into a scene instead of the current render layer.
+    /// The scene is cleared first. Recordings can be nested.
+    void push_scene(const std::shared_ptr<Pathfinder::Scene> &scene);
+
+    /// Stop recording, and resume drawing to the previous scene.
+    void pop_scene();
+
+    bool is_recording() const;
+
+    /// Render a scene into a texture immediately, e.g. to cache a recorded scene.
+    void render_scene_to_texture(const std::shared_ptr<Pathfinder::Scene> &scene,
+                                 const std::shared_ptr<Pathfinder::Texture> &texture);
+
+    /// Restrict drawing to a viewport (in logical global coordinates).
+    /// Nodes outside the clip rect are culled by draw_system.
+    /// @param intersect Intersect with the current clip rect, otherwise replace it.
+    void push_clip_rect(const RectF &rect, bool intersect = true);
+
+    void pop_clip_rect();
+
+    /// Check if a rect (in logical global coordinates) overlaps the current clip rect.
+    bool is_rect_visible(const RectF &rect) const;
+
     // Only used with ScrollContainer.
     Transform2 global_transform_offset;
 
 private:
     void reset_render_layers();
 
+    /// Invalidate the layer being drawn to, or the layer a scene is being recorded for.
+    void invalidate_current_layer();
+
+    /// Layer states from the last submission to a destination texture.
+    struct LayerCache {
+        std::weak_ptr<Pathfinder::Texture> dst_texture;
+
+        /// Zero for empty layers.
+        std::array<uint64_t, MAX_RENDER_LAYER> scene_hashes{};
+
+        /// Only used with layer caching.
+        std::array<std::shared_ptr<Pathfinder::Texture>, MAX_RENDER_LAYER> textures;
+    };
+
+    LayerCache &get_layer_cache(const std::shared_ptr<Pathfinder::Texture> &dst_texture);
+
+    /// Get the parsed SVG of an emoji glyph, scaled to unit size. Null if the glyph has no valid SVG.
+    /// Parsing resets the canvas state, so call this before setting up any state.
+    std::shared_ptr<Pathfinder::Scene> get_emoji_scene(Font &font, uint16_t glyph_index);
+
+    struct CachedSvg {
+        std::filesystem::file_time_type modified_time;
+        std::shared_ptr<Pathfinder::SvgScene> svg_scene;
+    };
+
+    /// Parsed SVGs keyed by path.
+    std::unordered_map<std::string, CachedSvg> svg_cache;
+
+    std::string svg_cache_dir;
+
+    /// Parsed emoji scenes keyed by font ID and glyph index, shared by all texts.
+    std::unordered_map<uint64_t, std::shared_ptr<Pathfinder::Scene>> emoji_scenes;
+
     // Never expose this.
     std::shared_ptr<Pathfinder::Canvas> canvas;
 
     std::array<std::shared_ptr<Pathfinder::Scene>, MAX_RENDER_LAYER> render_layers;
 
+    /// Layers whose content may have changed without changing their scenes.
+    std::array<bool, MAX_RENDER_LAYER> invalidated_layers{};
+
+    bool layer_caching = false;
+
+    /// One per window.
+    std::vector<LayerCache> layer_caches;
+
+    /// Used to composite cached layer textures.
+    std::shared_ptr<Pathfinder::Scene> composite_scene;
+
+    /// Scenes to resume when the current recordings end.
+    std::vector<std::shared_ptr<Pathfinder::Scene>> recording_stack;
+
     float global_scale_ = 1.0f;
+
+    /// Empty rects are kept as invalid rects.
+    std::vector<RectF> clip_rect_stack;
 };
 
 } // namespace revector
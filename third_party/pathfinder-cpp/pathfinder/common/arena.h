@@ -0,0 +1,159 @@
+#ifndef PATHFINDER_ARENA_H
+#define PATHFINDER_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace Pathfinder {
+
+/// A bump allocator for data that lives as long as a scene (usually a frame).
+/// Deallocation is a no-op, and reset() releases everything at once while keeping the memory blocks.
+/// Not thread-safe.
+class Arena {
+public:
+    explicit Arena(size_t _block_size = 64 * 1024) : block_size(_block_size) {
+    }
+
+    Arena(const Arena &) = delete;
+
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(size_t size, size_t alignment) {
+        while (current_block < blocks.size()) {
+            auto &block = blocks[current_block];
+
+            auto base = reinterpret_cast<uintptr_t>(block.data.get());
+            auto aligned = (base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+
+            if (aligned + size <= base + block.size) {
+                offset = aligned + size - base;
+                return reinterpret_cast<void *>(aligned);
+            }
+
+            // Move on to the next block, leaving the rest of this one unused until the next reset.
+            current_block++;
+            offset = 0;
+        }
+
+        // Oversized allocations get a block of their own.
+        size_t new_block_size = std::max(block_size, size + alignment);
+        blocks.push_back({std::make_unique<std::byte[]>(new_block_size), new_block_size});
+
+        current_block = blocks.size() - 1;
+        offset = 0;
+
+        return allocate(size, alignment);
+    }
+
+    /// Rewind to the first block in O(1). Everything allocated before is invalidated.
+    void reset() {
+        current_block = 0;
+        offset = 0;
+    }
+
+    /// Total size of the blocks held.
+    size_t get_capacity() const {
+        size_t capacity = 0;
+        for (auto &block : blocks) {
+            capacity += block.size;
+        }
+        return capacity;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+
+    size_t current_block = 0;
+
+    /// Offset in the current block.
+    size_t offset = 0;
+
+    size_t block_size;
+};
+
+/// An STL allocator backed by an arena. Without an arena, it allocates from the heap.
+///
+/// Copying a container never copies the arena along, as the copy may outlive the arena or be made
+/// on another thread. Use an allocator-extended copy to copy into an arena explicitly.
+/// Copy-constructed elements (e.g. by push_back) are given the container's arena if they accept an
+/// `Arena *` as the last constructor argument.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator() = default;
+
+    ArenaAllocator(Arena *_arena) : arena(_arena) {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.get_arena()) {
+    }
+
+    T *allocate(size_t n) {
+        if (arena) {
+            return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+        }
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t) {
+        if (!arena) {
+            ::operator delete(p);
+        }
+    }
+
+    template <typename U, typename... Args>
+    void construct(U *p, Args &&...args) {
+        if constexpr (sizeof...(Args) == 1 && std::is_constructible_v<U, Args &&..., Arena *> &&
+                      std::conjunction_v<std::is_lvalue_reference<Args &&>...>) {
+            new (p) U(std::forward<Args>(args)..., arena);
+        } else {
+            new (p) U(std::forward<Args>(args)...);
+        }
+    }
+
+    ArenaAllocator select_on_container_copy_construction() const {
+        return {};
+    }
+
+    Arena *get_arena() const {
+        return arena;
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const {
+        return arena == other.get_arena();
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const {
+        return arena != other.get_arena();
+    }
+
+private:
+    Arena *arena{};
+};
+
+/// A vector which can be placed in an arena.
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace Pathfinder
+
+#endif // PATHFINDER_ARENA_H
@@ -2,6 +2,7 @@
 #define PATHFINDER_BASIC_MATH_H
 
 #include <cstdint>
+#include <cstring>
 
 #include "../logger.h"
 
@@ -64,6 +65,27 @@ static uint64_t fnv_hash(const char* bytes, size_t size) {
     return hash;
 }
 
+/// Incremental 64-bit FNV-1a hasher, consuming a word at a time.
+class Hasher {
+public:
+    void write_u64(uint64_t value) {
+        state_ = (state_ ^ value) * 0x100000001b3;
+    }
+
+    void write_f32(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(float));
+        write_u64(bits);
+    }
+
+    uint64_t finish() const {
+        return state_;
+    }
+
+private:
+    uint64_t state_ = 0xcbf29ce484222325;
+};
+
 struct Range {
     /// The lower bound of the range (inclusive).
     unsigned long long start = 0;
@@ -25,6 +25,10 @@ bool Transform2::is_identity() const {
     return matrix == Mat2::from_scale({1, 1}) && vector == Vec2F();
 }
 
+bool Transform2::is_translation() const {
+    return matrix == Mat2::from_scale({1, 1});
+}
+
 Transform2 Transform2::inverse() const {
     auto matrix_inv = matrix.inverse();
     auto vector_inv = -(matrix_inv * vector);
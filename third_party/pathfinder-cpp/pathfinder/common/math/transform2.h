@@ -38,6 +38,9 @@ public:
 
     bool is_identity() const;
 
+    /// If this transform only translates.
+    bool is_translation() const;
+
     Transform2 inverse() const;
 
     /**
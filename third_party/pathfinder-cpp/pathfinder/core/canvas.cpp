@@ -149,22 +149,22 @@ Canvas::Canvas(Vec2I size,
     scene = std::make_shared<Scene>(0, RectF({0, 0}, size.to_f32()));
 }
 
-void Canvas::push_path(Outline &outline, PathOp path_op, FillRule fill_rule) {
+void Canvas::push_path(Outline &&outline, PathOp path_op, FillRule fill_rule) {
     // Get paint and push it to the scene's palette.
-    Paint paint = path_op == PathOp::Fill ? fill_paint() : stroke_paint();
-    auto paint_id = scene->push_paint(paint);
+    const Paint &paint = path_op == PathOp::Fill ? fill_paint() : stroke_paint();
+    auto paint_id = paint.is_color() ? scene->push_color_paint(paint.get_base_color()) : scene->push_paint(paint);
 
     auto transform = current_state.transform;
     auto clip_path = current_state.clip_path;
     auto blend_mode = current_state.global_composite_operation;
 
-    // Apply transform to the outline.
+    // Apply transform to the outline in place.
     outline.transform(transform);
 
     // Add shadow.
     if (current_state.shadow_color.is_opaque()) {
         // Copy outline.
-        Outline shadow_outline = outline;
+        Outline shadow_outline(outline, &scene->arena);
 
         // Set shadow offset.
         shadow_outline.transform(Transform2::from_translation(current_state.shadow_offset));
@@ -190,35 +190,57 @@ void Canvas::push_path(Outline &outline, PathOp path_op, FillRule fill_rule) {
 
         // Create a new draw path from the outline.
         DrawPath path;
-        path.outline = shadow_outline;
+        path.outline = std::move(shadow_outline);
         path.paint = shadow_paint_id;
         path.fill_rule = fill_rule;
         path.blend_mode = blend_mode;
 
         // This path goes to the blur viewport x.
-        scene->push_draw_path(path);
+        scene->push_draw_path(std::move(path));
 
         composite_shadow_blur_render_targets(*scene, shadow_blur_info);
     }
 
     DrawPath path;
-    path.outline = outline;
+    path.outline = std::move(outline);
     path.paint = paint_id;
     path.clip_path = clip_path;
     path.fill_rule = fill_rule;
     path.blend_mode = blend_mode;
 
-    scene->push_draw_path(path);
+    scene->push_draw_path(std::move(path));
+}
+
+Path2d Canvas::create_path() const {
+    return Path2d(&scene->arena);
 }
 
 void Canvas::fill_path(Path2d &path2d, FillRule fill_rule) {
     if (current_state.fill_paint.is_opaque()) {
-        auto outline = path2d.into_outline();
-        push_path(outline, PathOp::Fill, fill_rule);
+        push_path(path2d.into_outline(&scene->arena), PathOp::Fill, fill_rule);
+    }
+}
+
+void Canvas::fill_path(Path2d &&path2d, FillRule fill_rule) {
+    if (current_state.fill_paint.is_opaque()) {
+        push_path(std::move(path2d).into_outline(), PathOp::Fill, fill_rule);
     }
 }
 
 void Canvas::stroke_path(Path2d &path2d) {
+    // No need to draw an invisible stroke.
+    if (current_state.stroke_paint.is_opaque() && current_state.line_width > 0) {
+        stroke_outline(path2d.into_outline(&scene->arena));
+    }
+}
+
+void Canvas::stroke_path(Path2d &&path2d) {
+    if (current_state.stroke_paint.is_opaque() && current_state.line_width > 0) {
+        stroke_outline(std::move(path2d).into_outline());
+    }
+}
+
+void Canvas::stroke_outline(Outline &&outline) {
     // Set stroke style.
     auto style = StrokeStyle();
     style.line_width = line_width();
@@ -226,64 +248,80 @@ void Canvas::stroke_path(Path2d &path2d) {
     style.miter_limit = miter_limit();
     style.line_cap = line_cap();
 
-    // No need to draw an invisible stroke.
-    if (current_state.stroke_paint.is_opaque() && style.line_width > 0) {
-        auto outline = path2d.into_outline();
-
-        // Do dash before converting stroke to fill.
-        if (!current_state.line_dash.empty()) {
-            auto dasher = OutlineDash(outline, current_state.line_dash, 0);
-            dasher.dash();
-            outline = dasher.into_outline();
-        }
-
-        auto stroke_to_fill = OutlineStrokeToFill(outline, style);
+    // Do dash before converting stroke to fill.
+    if (!current_state.line_dash.empty()) {
+        auto dasher = OutlineDash(outline, current_state.line_dash, 0);
+        dasher.dash();
+        outline = dasher.into_outline();
+    }
 
-        // Do stroking.
-        stroke_to_fill.offset();
+    auto stroke_to_fill = OutlineStrokeToFill(outline, style, &scene->arena);
 
-        auto stroke_outline = stroke_to_fill.into_outline();
+    // Do stroking.
+    stroke_to_fill.offset();
 
-        // Even-Odd fill rule is not applicable for strokes.
-        push_path(stroke_outline, PathOp::Stroke, FillRule::Winding);
-    }
+    // Even-Odd fill rule is not applicable for strokes.
+    push_path(stroke_to_fill.into_outline(), PathOp::Stroke, FillRule::Winding);
 }
 
 void Canvas::clip_path(Path2d &path, FillRule fill_rule) {
-    auto outline = path.into_outline();
+    push_clip_path(path.into_outline(&scene->arena), fill_rule);
+}
+
+void Canvas::clip_path(Path2d &&path, FillRule fill_rule) {
+    push_clip_path(std::move(path).into_outline(), fill_rule);
+}
+
+void Canvas::push_clip_path(Outline &&outline, FillRule fill_rule) {
     outline.transform(current_state.transform);
 
     ClipPath clip_path;
-    clip_path.outline = outline;
+    clip_path.outline = std::move(outline);
     clip_path.fill_rule = fill_rule;
     clip_path.clip_path = current_state.clip_path;
 
-    uint32_t clip_path_id = scene->push_clip_path(clip_path);
-    current_state.clip_path = std::make_shared<uint32_t>(clip_path_id);
+    uint32_t clip_path_id = scene->push_clip_path(std::move(clip_path));
+    set_state_field(BrushField::ClipPath, &BrushState::clip_path, std::make_shared<uint32_t>(clip_path_id));
 }
 
-Paint Canvas::fill_paint() const {
+const Paint &Canvas::fill_paint() const {
     return current_state.fill_paint;
 }
 
 void Canvas::set_fill_paint(const Paint &new_fill_paint) {
-    current_state.fill_paint = new_fill_paint;
+    set_state_field(BrushField::FillPaint, &BrushState::fill_paint, new_fill_paint);
 }
 
-Paint Canvas::stroke_paint() const {
+void Canvas::set_fill_color(const ColorU &new_fill_color) {
+    auto &paint = current_state.fill_paint;
+    if (paint.is_color() && paint.get_base_color().to_u32() == new_fill_color.to_u32()) {
+        return;
+    }
+    set_fill_paint(Paint::from_color(new_fill_color));
+}
+
+const Paint &Canvas::stroke_paint() const {
     return current_state.stroke_paint;
 }
 
 void Canvas::set_stroke_paint(const Paint &new_stroke_paint) {
-    current_state.stroke_paint = new_stroke_paint;
+    set_state_field(BrushField::StrokePaint, &BrushState::stroke_paint, new_stroke_paint);
 }
 
 float Canvas::line_width() const {
     return current_state.line_width;
 }
 
+void Canvas::set_stroke_color(const ColorU &new_stroke_color) {
+    auto &paint = current_state.stroke_paint;
+    if (paint.is_color() && paint.get_base_color().to_u32() == new_stroke_color.to_u32()) {
+        return;
+    }
+    set_stroke_paint(Paint::from_color(new_stroke_color));
+}
+
 void Canvas::set_line_width(float new_line_width) {
-    current_state.line_width = new_line_width;
+    set_state_field(BrushField::LineWidth, &BrushState::line_width, new_line_width);
 }
 
 LineCap Canvas::line_cap() const {
@@ -291,7 +329,7 @@ LineCap Canvas::line_cap() const {
 }
 
 void Canvas::set_line_cap(LineCap new_line_cap) {
-    current_state.line_cap = new_line_cap;
+    set_state_field(BrushField::LineCap, &BrushState::line_cap, new_line_cap);
 }
 
 LineJoin Canvas::line_join() const {
@@ -299,7 +337,7 @@ LineJoin Canvas::line_join() const {
 }
 
 void Canvas::set_line_join(LineJoin new_line_join) {
-    current_state.line_join = new_line_join;
+    set_state_field(BrushField::LineJoin, &BrushState::line_join, new_line_join);
 }
 
 float Canvas::miter_limit() const {
@@ -307,7 +345,7 @@ float Canvas::miter_limit() const {
 }
 
 void Canvas::set_miter_limit(float new_miter_limit) {
-    current_state.miter_limit = new_miter_limit;
+    set_state_field(BrushField::MiterLimit, &BrushState::miter_limit, new_miter_limit);
 }
 
 float Canvas::shadow_blur() const {
@@ -315,7 +353,7 @@ float Canvas::shadow_blur() const {
 }
 
 void Canvas::set_shadow_blur(float new_shadow_blur) {
-    current_state.shadow_blur = new_shadow_blur;
+    set_state_field(BrushField::ShadowBlur, &BrushState::shadow_blur, new_shadow_blur);
 }
 
 ColorU Canvas::shadow_color() const {
@@ -323,7 +361,7 @@ ColorU Canvas::shadow_color() const {
 }
 
 void Canvas::set_shadow_color(const ColorU &new_shadow_color) {
-    current_state.shadow_color = new_shadow_color;
+    set_state_field(BrushField::ShadowColor, &BrushState::shadow_color, new_shadow_color);
 }
 
 Vec2F Canvas::shadow_offset() const {
@@ -331,15 +369,15 @@ Vec2F Canvas::shadow_offset() const {
 }
 
 void Canvas::set_shadow_offset(const Vec2F &new_shadow_offset) {
-    current_state.shadow_offset = new_shadow_offset;
+    set_state_field(BrushField::ShadowOffset, &BrushState::shadow_offset, new_shadow_offset);
 }
 
-std::vector<float> Canvas::line_dash() const {
+const std::vector<float> &Canvas::line_dash() const {
     return current_state.line_dash;
 }
 
 void Canvas::set_line_dash(const std::vector<float> &new_line_dash) {
-    current_state.line_dash = new_line_dash;
+    set_state_field(BrushField::LineDash, &BrushState::line_dash, new_line_dash);
 }
 
 float Canvas::line_dash_offset() const {
@@ -347,7 +385,7 @@ float Canvas::line_dash_offset() const {
 }
 
 void Canvas::set_line_dash_offset(float new_line_dash_offset) {
-    current_state.line_dash_offset = new_line_dash_offset;
+    set_state_field(BrushField::LineDashOffset, &BrushState::line_dash_offset, new_line_dash_offset);
 }
 
 Transform2 Canvas::get_transform() const {
@@ -355,44 +393,44 @@ Transform2 Canvas::get_transform() const {
 }
 
 void Canvas::set_transform(const Transform2 &new_transform) {
-    current_state.transform = new_transform;
+    set_state_field(BrushField::Transform, &BrushState::transform, new_transform);
 }
 
 void Canvas::set_global_alpha(float new_global_alpha) {
-    current_state.global_alpha = new_global_alpha;
+    set_state_field(BrushField::GlobalAlpha, &BrushState::global_alpha, new_global_alpha);
 }
 
 void Canvas::set_global_composite_operation(BlendMode new_composite_operation) {
-    current_state.global_composite_operation = new_composite_operation;
+    set_state_field(BrushField::GlobalCompositeOperation, &BrushState::global_composite_operation, new_composite_operation);
 }
 
 void Canvas::fill_rect(const RectF &rect) {
-    Path2d path;
+    auto path = create_path();
     path.add_rect(rect);
-    fill_path(path, FillRule::Winding);
+    fill_path(std::move(path), FillRule::Winding);
 }
 
 void Canvas::stroke_rect(const RectF &rect) {
-    Path2d path;
+    auto path = create_path();
     path.add_rect(rect);
-    stroke_path(path);
+    stroke_path(std::move(path));
 }
 
 void Canvas::clear_rect(const RectF &rect) {
-    Path2d path;
+    auto path = create_path();
     path.add_rect(rect);
 
     auto paint = Paint::from_color(ColorU::transparent_black());
     auto paint_id = scene->push_paint(paint);
 
-    auto outline = path.into_outline();
+    auto outline = std::move(path).into_outline();
     outline.transform(current_state.transform);
 
     DrawPath draw_path;
-    draw_path.outline = outline;
+    draw_path.outline = std::move(outline);
     draw_path.paint = paint_id;
     draw_path.blend_mode = BlendMode::Clear;
-    scene->push_draw_path(draw_path);
+    scene->push_draw_path(std::move(draw_path));
 }
 
 void Canvas::draw_image(const std::shared_ptr<Image> &image, const RectF &dst_rect) {
@@ -454,6 +492,13 @@ void Canvas::draw_sub_render_target(const RenderTargetId &render_target_id,
 void Canvas::draw_raw_texture(std::shared_ptr<Texture> texture, const RectF &dst_rect) {
     auto src_rect = RectF({}, texture->get_size().to_f32());
 
+    draw_raw_sub_texture(texture, src_rect, dst_rect);
+}
+
+void Canvas::draw_raw_sub_texture(const std::shared_ptr<Texture> &texture,
+                                  const RectF &src_rect,
+                                  const RectF &dst_rect,
+                                  float alpha) {
     auto dst_size = dst_rect.size();
     auto scale = dst_size / src_rect.size();
     auto offset = dst_rect.origin() - src_rect.origin() * scale;
@@ -466,6 +511,9 @@ void Canvas::draw_raw_texture(std::shared_ptr<Texture> texture, const RectF &dst
     auto old_fill_paint = current_state.fill_paint;
 
     current_state.fill_paint = Paint::from_pattern(pattern);
+    if (alpha < 1) {
+        current_state.fill_paint.set_base_color(ColorU(255, 255, 255, (uint8_t)std::round(clamp(alpha, 0.f, 1.f) * 255)));
+    }
     fill_rect(dst_rect);
 
     // Restore the previous fill paint.
@@ -484,14 +532,83 @@ std::shared_ptr<Texture> Canvas::get_dst_texture() {
     return renderer->get_dest_texture();
 }
 
+template <typename T>
+void Canvas::set_state_field(BrushField field, T BrushState::*member, const T &value) {
+    auto field_bit = static_cast<uint32_t>(field);
+
+    // Remember the value at the time of the last save, if it's the first change since then.
+    if (!saved_states.empty() && !(saved_states.back().modified_fields & field_bit)) {
+        saved_states.back().modified_fields |= field_bit;
+        undo_log.push_back({field, current_state.*member});
+    }
+
+    current_state.*member = value;
+}
+
 void Canvas::save_state() {
-    saved_states.push_back(current_state);
+    saved_states.push_back({0, undo_log.size()});
 }
 
 void Canvas::restore_state() {
-    if (!saved_states.empty()) {
-        current_state = saved_states.back();
-        saved_states.pop_back();
+    if (saved_states.empty()) {
+        return;
+    }
+
+    auto undo_start = saved_states.back().undo_start;
+    saved_states.pop_back();
+
+    while (undo_log.size() > undo_start) {
+        auto &undo = undo_log.back();
+
+        switch (undo.field) {
+            case BrushField::Transform:
+                current_state.transform = std::get<Transform2>(undo.value);
+                break;
+            case BrushField::LineWidth:
+                current_state.line_width = std::get<float>(undo.value);
+                break;
+            case BrushField::LineCap:
+                current_state.line_cap = std::get<LineCap>(undo.value);
+                break;
+            case BrushField::LineJoin:
+                current_state.line_join = std::get<LineJoin>(undo.value);
+                break;
+            case BrushField::MiterLimit:
+                current_state.miter_limit = std::get<float>(undo.value);
+                break;
+            case BrushField::LineDash:
+                current_state.line_dash = std::move(std::get<std::vector<float>>(undo.value));
+                break;
+            case BrushField::LineDashOffset:
+                current_state.line_dash_offset = std::get<float>(undo.value);
+                break;
+            case BrushField::FillPaint:
+                current_state.fill_paint = std::move(std::get<Paint>(undo.value));
+                break;
+            case BrushField::StrokePaint:
+                current_state.stroke_paint = std::move(std::get<Paint>(undo.value));
+                break;
+            case BrushField::ShadowColor:
+                current_state.shadow_color = std::get<ColorU>(undo.value);
+                break;
+            case BrushField::ShadowBlur:
+                current_state.shadow_blur = std::get<float>(undo.value);
+                break;
+            case BrushField::ShadowOffset:
+                current_state.shadow_offset = std::get<Vec2F>(undo.value);
+                break;
+            case BrushField::GlobalAlpha:
+                current_state.global_alpha = std::get<float>(undo.value);
+                break;
+            case BrushField::GlobalCompositeOperation:
+                current_state.global_composite_operation = std::get<BlendMode>(undo.value);
+                break;
+            case BrushField::ClipPath:
+                current_state.clip_path = std::move(std::get<std::shared_ptr<uint32_t>>(undo.value));
+                break;
+        }
+
+        undo_log.pop_back();
     }
 }
 
@@ -500,6 +617,8 @@ void Canvas::draw(bool clear_dst_texture) {
         return;
     }
 
+    scene->expand_instances();
+
     scene_builder->build(scene.get(), renderer.get());
 
     renderer->draw(scene_builder, clear_dst_texture);
@@ -519,6 +638,7 @@ void Canvas::set_scene(const std::shared_ptr<Scene> &new_scene) {
     // Because the clip path doesn't exist in the new scene but only in the previous scene.
     current_state = {};
     saved_states.clear();
+    undo_log.clear();
 }
 
 std::shared_ptr<Scene> Canvas::take_scene() {
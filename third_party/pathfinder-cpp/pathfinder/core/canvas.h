@@ -2,6 +2,7 @@
 #define PATHFINDER_CANVAS_H
 
 #include <memory>
+#include <variant>
 
 #include "path2d.h"
 #include "renderer.h"
@@ -45,6 +46,25 @@ enum class PathOp {
     Stroke,
 };
 
+/// Fields of BrushState, as bits.
+enum class BrushField : uint32_t {
+    Transform = 1 << 0,
+    LineWidth = 1 << 1,
+    LineCap = 1 << 2,
+    LineJoin = 1 << 3,
+    MiterLimit = 1 << 4,
+    LineDash = 1 << 5,
+    LineDashOffset = 1 << 6,
+    FillPaint = 1 << 7,
+    StrokePaint = 1 << 8,
+    ShadowColor = 1 << 9,
+    ShadowBlur = 1 << 10,
+    ShadowOffset = 1 << 11,
+    GlobalAlpha = 1 << 12,
+    GlobalCompositeOperation = 1 << 13,
+    ClipPath = 1 << 14,
+};
+
 /// Normally, we only need one canvas to render multiple scenes.
 class Canvas {
 public:
@@ -78,7 +98,7 @@ public:
 
     void set_miter_limit(float new_miter_limit);
 
-    std::vector<float> line_dash() const;
+    const std::vector<float> &line_dash() const;
 
     void set_line_dash(const std::vector<float> &new_line_dash);
 
@@ -88,14 +108,20 @@ public:
 
     // Fill & stroke styles
 
-    Paint fill_paint() const;
+    const Paint &fill_paint() const;
 
     void set_fill_paint(const Paint &new_fill_paint);
 
-    Paint stroke_paint() const;
+    /// Same as set_fill_paint() with a solid color paint, but does nothing if the color is already set.
+    void set_fill_color(const ColorU &new_fill_color);
+
+    const Paint &stroke_paint() const;
 
     void set_stroke_paint(const Paint &new_stroke_paint);
 
+    /// Same as set_stroke_paint() with a solid color paint, but does nothing if the color is already set.
+    void set_stroke_color(const ColorU &new_stroke_color);
+
     // Shadows
 
     float shadow_blur() const;
@@ -123,11 +149,24 @@ public:
 
     // Drawing paths.
     // ------------------------------------------------
+    /// An empty path built in the scene's arena, which the drawing calls below move into the scene
+    /// without copying. It must be drawn before the scene is cleared or destroyed.
+    Path2d create_path() const;
+
+    /// Copies the outline of the path into the scene's arena.
     void fill_path(Path2d &path2d, FillRule fill_rule);
 
+    /// Consumes the path. Its outline is moved into the scene if it was built by create_path(),
+    /// and copied into the scene's arena otherwise.
+    void fill_path(Path2d &&path2d, FillRule fill_rule);
+
     void stroke_path(Path2d &path2d);
 
+    void stroke_path(Path2d &&path2d);
+
     void clip_path(Path2d &path2d, FillRule fill_rule);
+
+    void clip_path(Path2d &&path2d, FillRule fill_rule);
     // ------------------------------------------------
 
     // Drawing rectangles
@@ -150,6 +189,12 @@ public:
 
     void draw_raw_texture(std::shared_ptr<Texture> texture, const RectF &dst_rect);
 
+    /// @param alpha Opacity multiplied with the texture.
+    void draw_raw_sub_texture(const std::shared_ptr<Texture> &texture,
+                              const RectF &src_rect,
+                              const RectF &dst_rect,
+                              float alpha = 1);
+
     /// Set the inner scene's view box.
     void set_size(const Vec2I &size);
 
@@ -164,7 +209,7 @@ public:
     /// Returns the inner scene, replacing it with a blank scene.
     std::shared_ptr<Scene> take_scene();
 
-    // Brush state
+    // Brush state. Saving is cheap, as only the fields modified afterward are stored.
 
     void save_state();
 
@@ -183,11 +228,37 @@ private:
      * @param path_op Fill/Stroke
      * @param fill_rule Winding/Even-Odd
      */
-    void push_path(Outline &outline, PathOp path_op, FillRule fill_rule);
+    void push_path(Outline &&outline, PathOp path_op, FillRule fill_rule);
+
+    void stroke_outline(Outline &&outline);
+
+    void push_clip_path(Outline &&outline, FillRule fill_rule);
+
+    /// Set a brush state field, remembering its old value for restore_state().
+    template <typename T>
+    void set_state_field(BrushField field, T BrushState::*member, const T &value);
 
     /// Brush state management.
     BrushState current_state;
-    std::vector<BrushState> saved_states;
+
+    /// Old value of a brush state field.
+    struct BrushFieldUndo {
+        BrushField field;
+        std::variant<Transform2, float, LineCap, LineJoin, std::vector<float>, Paint, ColorU, Vec2F, BlendMode,
+                     std::shared_ptr<uint32_t>>
+            value;
+    };
+
+    struct SavedState {
+        /// Fields modified since the save, as BrushField bits.
+        uint32_t modified_fields = 0;
+
+        /// Start of the undo entries of this save.
+        size_t undo_start = 0;
+    };
+
+    std::vector<SavedState> saved_states;
+    std::vector<BrushFieldUndo> undo_log;
 
     std::shared_ptr<Scene> scene;
 
@@ -250,6 +250,9 @@ void SceneBuilderD3D11::build_tile_batches(LastSceneInfo &last_scene,
                     tile_batches.push_back(batch);
                 }
             } break;
+            case DisplayItem::Type::DrawScene: {
+                // Instances are expanded by the canvas before building.
+            } break;
         }
     }
 }
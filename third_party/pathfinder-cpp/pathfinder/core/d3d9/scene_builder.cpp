@@ -285,6 +285,9 @@ void SceneBuilderD3D9::build_tile_batches(const std::vector<BuiltDrawPath> &buil
                     tile_batches.push_back(batch);
                 }
             } break;
+            case DisplayItem::Type::DrawScene: {
+                // Instances are expanded by the canvas before building.
+            } break;
         }
     }
 }
@@ -56,10 +56,10 @@ void OutlineDash::dash() {
 
 Outline OutlineDash::into_outline() {
     if (state.is_on()) {
-        output.push_contour(state.output);
+        output.push_contour(std::move(state.output));
     }
 
-    return output;
+    return std::move(output);
 }
 
 ContourDash::ContourDash(Contour &_input, Outline &_output, DashState &_state)
@@ -26,6 +26,7 @@ struct OutlineDash {
 
     void dash();
 
+    /// Moves the output out, so it can only be called once.
     Outline into_outline();
 };
 
@@ -4,6 +4,11 @@
 
 namespace Pathfinder {
 
+Contour::Contour(Arena *arena) : points(arena), flags(arena) {}
+
+Contour::Contour(const Contour &other, Arena *arena)
+    : points(other.points, arena), flags(other.flags, arena), bounds(other.bounds), closed(other.closed) {}
+
 Vec2F Contour::position_of_last(int index) {
     return points[points.size() - index];
 }
@@ -96,6 +101,19 @@ void Contour::push_cubic(const Vec2F &ctrl0, const Vec2F &ctrl1, const Vec2F &to
 }
 
 void Contour::transform(const Transform2 &transform) {
+    // Translations are common (e.g. instanced icons), and don't need the bounds to be recomputed.
+    if (transform.is_translation()) {
+        if (points.empty()) {
+            return;
+        }
+        auto translation = transform.get_position();
+        for (auto &point : points) {
+            point += translation;
+        }
+        bounds += translation;
+        return;
+    }
+
     for (int i = 0; i < points.size(); i++) {
         auto &point = points[i];
         point = transform * point;
@@ -104,7 +122,7 @@ void Contour::transform(const Transform2 &transform) {
     }
 }
 
-SegmentsIter::SegmentsIter(const std::vector<Vec2F> &_points, const std::vector<PointFlag> &_flags, bool _closed)
+SegmentsIter::SegmentsIter(const ArenaVector<Vec2F> &_points, const ArenaVector<PointFlag> &_flags, bool _closed)
     : points(_points), flags(_flags), closed(_closed) {}
 
 Segment SegmentsIter::get_next(bool force_closed) {
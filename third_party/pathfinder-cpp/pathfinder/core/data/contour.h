@@ -3,6 +3,7 @@
 
 #include <vector>
 
+#include "../../common/arena.h"
 #include "../../common/math/rect.h"
 #include "../../common/math/transform2.h"
 #include "../../common/math/vec2.h"
@@ -19,8 +20,14 @@ class Contour {
 public:
     Contour() = default;
 
-    std::vector<Vec2F> points;
-    std::vector<PointFlag> flags;
+    /// An empty contour whose points are allocated from an arena.
+    explicit Contour(Arena *arena);
+
+    /// Copy a contour into an arena.
+    Contour(const Contour &other, Arena *arena);
+
+    ArenaVector<Vec2F> points;
+    ArenaVector<PointFlag> flags;
 
     RectF bounds = RectF();
 
@@ -79,7 +86,7 @@ public:
 /// An iterator used to traverse segments efficiently in a contour.
 class SegmentsIter {
 public:
-    SegmentsIter(const std::vector<Vec2F> &_points, const std::vector<PointFlag> &_flags, bool _closed);
+    SegmentsIter(const ArenaVector<Vec2F> &_points, const ArenaVector<PointFlag> &_flags, bool _closed);
 
     /// Get next segment in the contour.
     Segment get_next(bool force_closed = false);
@@ -88,8 +95,8 @@ public:
 
 private:
     /// Contour data.
-    const std::vector<Vec2F> &points;
-    const std::vector<PointFlag> &flags;
+    const ArenaVector<Vec2F> &points;
+    const ArenaVector<PointFlag> &flags;
 
     /// If the contour is closed.
     bool closed = false;
@@ -4,6 +4,24 @@
 
 namespace Pathfinder {
 
+Outline::Outline(Arena *arena) : contours(arena) {}
+
+Outline::Outline(const Outline &other, Arena *arena) : contours(other.contours, arena), bounds(other.bounds) {}
+
+bool Outline::is_in_arena(const Arena *arena) const {
+    if (contours.get_allocator().get_arena() != arena) {
+        return false;
+    }
+
+    for (auto &contour : contours) {
+        if (contour.points.get_allocator().get_arena() != arena || contour.flags.get_allocator().get_arena() != arena) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 void Outline::transform(const Transform2 &transform) {
     if (transform.is_identity()) {
         return;
@@ -26,15 +44,30 @@ void Outline::push_contour(const Contour &_contour) {
         return;
     }
 
-    // Push contour.
+    // Update bounds.
+    bounds = bounds.union_rect(_contour.bounds);
+
+    // Copied into our arena.
     contours.push_back(_contour);
+}
 
-    // Update bounds.
-    if (contours.empty()) {
-        bounds = _contour.bounds;
-    } else {
-        bounds = bounds.union_rect(_contour.bounds);
+void Outline::push_contour(Contour &&_contour) {
+    if (_contour.is_empty()) {
+        return;
     }
+
+    // A contour from another arena is copied, so that the outline has a single owner of its memory.
+    if (_contour.points.get_allocator() != contours.get_allocator() ||
+        _contour.flags.get_allocator() != contours.get_allocator()) {
+        push_contour(static_cast<const Contour &>(_contour));
+        return;
+    }
+
+    // Update bounds.
+    bounds = bounds.union_rect(_contour.bounds);
+
+    // Push contour.
+    contours.push_back(std::move(_contour));
 }
 
 } // namespace Pathfinder
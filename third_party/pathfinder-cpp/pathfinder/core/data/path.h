@@ -13,7 +13,18 @@ namespace Pathfinder {
 /// Outlines consist of contours (a.k.a. sub-paths).
 class Outline {
 public:
-    std::vector<Contour> contours;
+    Outline() = default;
+
+    /// An empty outline whose contours are allocated from an arena.
+    explicit Outline(Arena *arena);
+
+    /// Copy an outline and its contours into an arena.
+    Outline(const Outline &other, Arena *arena);
+
+    /// Check if the outline and all its contours are allocated from an arena.
+    bool is_in_arena(const Arena *arena) const;
+
+    ArenaVector<Contour> contours;
 
     /// Bounding box.
     RectF bounds;
@@ -22,12 +33,21 @@ public:
     /// Applies an affine transform to this shape and all its paths.
     void transform(const Transform2 &transform);
 
-    /// Add a new contour to this shape.
+    /// Add a new contour to this shape. Contours are kept in the outline's arena.
     void push_contour(const Contour &_contour);
+
+    void push_contour(Contour &&_contour);
 };
 
 /// A thin wrapper over Outline, which describes a path that can be drawn.
 struct DrawPath {
+    DrawPath() = default;
+
+    /// Copy a draw path, placing its outline in an arena.
+    DrawPath(const DrawPath &other, Arena *arena)
+        : outline(other.outline, arena), paint(other.paint), clip_path(other.clip_path),
+          fill_rule(other.fill_rule), blend_mode(other.blend_mode) {}
+
     /// The actual vector path.
     Outline outline;
 
@@ -46,6 +66,12 @@ struct DrawPath {
 
 /// A thin wrapper over Outline, which describes a path that can be used to clip other paths.
 struct ClipPath {
+    ClipPath() = default;
+
+    /// Copy a clip path, placing its outline in an arena.
+    ClipPath(const ClipPath &other, Arena *arena)
+        : outline(other.outline, arena), clip_path(other.clip_path), fill_rule(other.fill_rule) {}
+
     /// The actual vector path.
     Outline outline;
 
@@ -126,6 +126,10 @@ public:
     /// Returns true if all colors of all stops in this gradient are opaque.
     bool is_opaque();
 
+    const std::vector<ColorStop> &get_stops() const {
+        return stops;
+    }
+
     // For being used as ordered key.
     inline bool operator<(const Gradient &rhs) const {
         if (wrap == rhs.wrap) {
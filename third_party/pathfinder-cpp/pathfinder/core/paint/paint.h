@@ -145,6 +145,11 @@ public:
     /// Returns the paint overlay, which is the portion of the paint on top of the base color.
     std::shared_ptr<PaintOverlay> get_overlay() const;
 
+    /// Returns true if this paint is a solid color, i.e. has no overlay.
+    bool is_color() const {
+        return overlay == nullptr;
+    }
+
     /// In order to use Paint as Map keys.
     /// See https://stackoverflow.com/questions/1102392/how-can-i-use-stdmaps-with-user-defined-types-as-key.
     bool operator<(const Paint &rhs) const {
@@ -162,7 +167,8 @@ public:
 
 struct ImageTexelInfo {
     TextureLocation location;
-    std::shared_ptr<std::vector<ColorU>> texels;
+    /// Texels are read from the image directly.
+    std::shared_ptr<const Image> image;
 };
 
 struct PaintMetadata;
@@ -77,21 +77,33 @@ FilterParams compute_filter_params(const PaintFilter &filter,
 Palette::Palette(uint32_t _scene_id) : scene_id(_scene_id) {}
 
 uint32_t Palette::push_paint(const Paint &paint) {
-    // Check if this paint already exists.
-    // FIXME: caching is only for pure-color paints for now.
-    if (paint.get_overlay() == nullptr) {
-        auto iter = cache.find(paint);
-        if (iter != cache.end()) {
-            return iter->second;
-        }
+    if (paint.is_color()) {
+        return push_color(paint.get_base_color());
+    }
+
+    auto result = overlay_paints.try_emplace({paint.get_overlay().get(), paint.get_base_color().to_u32()}, paints.size());
+    if (result.second) {
+        paints.push_back(paint);
+    }
+
+    return result.first->second;
+}
+
+uint32_t Palette::push_color(const ColorU &color) {
+    auto result = color_paints.try_emplace(color.to_u32(), paints.size());
+    if (result.second) {
+        paints.push_back(Paint::from_color(color));
     }
 
-    // Push.
-    uint32_t paint_id = paints.size();
-    cache.insert({paint, paint_id});
-    paints.push_back(paint);
+    return result.first->second;
+}
+
+uint32_t Palette::get_paint_count() const {
+    return paints.size();
+}
 
-    return paint_id;
+bool Palette::is_solid_colors_only() const {
+    return render_targets_desc.empty() && overlay_paints.empty();
 }
 
 Paint Palette::get_paint(uint32_t paint_id) const {
@@ -102,6 +114,13 @@ Paint Palette::get_paint(uint32_t paint_id) const {
     return paints[paint_id];
 }
 
+void Palette::clear() {
+    paints.clear();
+    render_targets_desc.clear();
+    color_paints.clear();
+    overlay_paints.clear();
+}
+
 RenderTargetId Palette::push_render_target(const RenderTargetDesc &render_target_desc) {
     uint32_t id = render_targets_desc.size();
     render_targets_desc.push_back(render_target_desc);
@@ -113,7 +132,8 @@ RenderTargetDesc Palette::get_render_target(RenderTargetId render_target_id) con
 }
 
 std::vector<PaintMetadata> Palette::build_paint_info(Renderer *renderer) {
-    auto paint_texture_manager = std::make_shared<PaintTextureManager>();
+    // Owned by the renderer, so that cached images stay allocated in their texture pages.
+    auto paint_texture_manager = renderer->get_paint_texture_manager();
 
     std::vector<TextureLocation> transient_paint_locations;
 
@@ -144,7 +164,7 @@ std::vector<PaintMetadata> Palette::build_paint_info(Renderer *renderer) {
 
         // Gradient tiles.
         for (auto &tile : paint_locations_info.gradient_tile_builder.tiles) {
-            renderer->upload_texel_data(tile.texels,
+            renderer->upload_texel_data(tile.texels.data(),
                                         TextureLocation{tile.page, RectI(Vec2I(0, 0), Vec2I(GRADIENT_TILE_LENGTH))});
         }
 
@@ -153,7 +173,7 @@ std::vector<PaintMetadata> Palette::build_paint_info(Renderer *renderer) {
         for (auto &texel_info : paint_locations_info.image_texel_info) {
             // Skip repeated image pages.
             if (uploaded_image_pages.find(texel_info.location.page) == uploaded_image_pages.end()) {
-                renderer->upload_texel_data(*texel_info.texels, texel_info.location);
+                renderer->upload_texel_data(texel_info.image->get_pixels(), texel_info.location);
                 uploaded_image_pages.insert(texel_info.location.page);
             }
         }
@@ -284,26 +304,28 @@ PaintLocationsInfo Palette::assign_paint_locations(const std::shared_ptr<PaintTe
 
                     auto &cached_images = texture_manager->cached_images;
 
-                    // Check cache.
-                    if (cached_images.find(image_hash) != cached_images.end()) {
-                        location = cached_images[image_hash];
-                        // Mark this image cache as being used in this frame.
-                        used_image_hashes.insert(image_hash);
+                    // Check cache. Cached images keep their page contents, so only new ones are uploaded.
+                    auto cached_image = cached_images.find(image_hash);
+                    if (cached_image != cached_images.end()) {
+                        location = cached_image->second;
                     } else {
                         // Leave a pixel of border on the side.
                         auto allocation_mode = AllocationMode::OwnPage;
                         location = allocator.allocate(image->size + border * 2, allocation_mode);
                         location.rect = location.rect.contract(border);
                         cached_images[image_hash] = location;
+
+                        image_texel_info.push_back(ImageTexelInfo{
+                            TextureLocation{
+                                location.page,
+                                location.rect,
+                            },
+                            image,
+                        });
                     }
 
-                    image_texel_info.push_back(ImageTexelInfo{
-                        TextureLocation{
-                            location.page,
-                            location.rect,
-                        },
-                        std::make_shared<std::vector<ColorU>>(image->pixels),
-                    });
+                    // Mark this image cache as being used in this frame.
+                    used_image_hashes.insert(image_hash);
                 }
 
                 TextureSamplingFlags sampling_flags;
@@ -466,8 +488,14 @@ MergedPaletteInfo Palette::append_palette(const Palette &palette, const Transfor
 
             if (contents.type == PaintContents::Type::Pattern) {
                 if (contents.pattern.source.type == PatternSource::Type::RenderTarget) {
-                    auto new_pattern = Pattern::from_render_target(contents.pattern.source.render_target_id,
-                                                                   contents.pattern.source.size);
+                    // Point to the merged render target.
+                    auto render_target_id = contents.pattern.source.render_target_id;
+                    auto iter = render_target_mapping.find(render_target_id);
+                    if (iter != render_target_mapping.end()) {
+                        render_target_id = iter->second;
+                    }
+
+                    auto new_pattern = Pattern::from_render_target(render_target_id, contents.pattern.source.size);
                     //                            new_pattern.set_filter(pattern.filter());
                     new_pattern.apply_transform(transform * contents.pattern.transform);
                     new_pattern.set_repeat_x(contents.pattern.repeat_x());
@@ -475,13 +503,19 @@ MergedPaletteInfo Palette::append_palette(const Palette &palette, const Transfor
                     new_pattern.set_smoothing_enabled(contents.pattern.smoothing_enabled());
 
                     auto new_paint = Paint::from_pattern(new_pattern);
-                    push_paint(new_paint);
+                    new_paint_id = push_paint(new_paint);
                 } else {
                     new_paint_id = push_paint(paint);
                 }
             } else {
-                contents.gradient.geometry.apply_transform(transform);
-                new_paint_id = push_paint(paint);
+                // Transform a copy, as the overlay is shared with the appended palette.
+                auto gradient = contents.gradient;
+                gradient.geometry.apply_transform(transform);
+
+                auto new_paint = Paint::from_gradient(gradient);
+                new_paint.set_base_color(paint.get_base_color());
+                new_paint.get_overlay()->composite_op = paint.get_overlay()->composite_op;
+                new_paint_id = push_paint(new_paint);
             }
         } else {
             new_paint_id = push_paint(paint);
@@ -514,4 +548,113 @@ void Palette::allocate_textures(const std::shared_ptr<PaintTextureManager> &text
     allocator.mark_all_pages_as_allocated();
 }
 
+namespace {
+
+void hash_transform(Hasher &hasher, const Transform2 &transform) {
+    hasher.write_f32(transform.m11());
+    hasher.write_f32(transform.m21());
+    hasher.write_f32(transform.m12());
+    hasher.write_f32(transform.m22());
+    hasher.write_f32(transform.m13());
+    hasher.write_f32(transform.m23());
+}
+
+void hash_vec2(Hasher &hasher, const Vec2F &vec) {
+    hasher.write_f32(vec.x);
+    hasher.write_f32(vec.y);
+}
+
+void hash_gradient(Hasher &hasher, const Gradient &gradient) {
+    auto &geometry = gradient.geometry;
+
+    hasher.write_u64((uint64_t)geometry.type);
+    hasher.write_u64((uint64_t)gradient.wrap);
+
+    if (geometry.type == GradientGeometry::Type::Linear) {
+        hash_vec2(hasher, geometry.linear.from());
+        hash_vec2(hasher, geometry.linear.to());
+    } else {
+        hash_vec2(hasher, geometry.radial.line.from());
+        hash_vec2(hasher, geometry.radial.line.to());
+        hash_vec2(hasher, geometry.radial.radii);
+        hash_transform(hasher, geometry.radial.transform);
+    }
+
+    for (auto &stop : gradient.get_stops()) {
+        hasher.write_f32(stop.offset);
+        hasher.write_u64(stop.color.to_u32());
+    }
+}
+
+void hash_pattern(Hasher &hasher, const Pattern &pattern) {
+    auto &source = pattern.source;
+
+    hasher.write_u64((uint64_t)source.type);
+
+    switch (source.type) {
+        case PatternSource::Type::Image: {
+            hasher.write_u64(source.image->get_hash());
+            hasher.write_u64((uint64_t)source.image->size.x << 32 | (uint32_t)source.image->size.y);
+        } break;
+        case PatternSource::Type::RenderTarget: {
+            hasher.write_u64(source.render_target_id.render_target);
+            hasher.write_u64(source.render_target_id.raw_texture_id ? *source.render_target_id.raw_texture_id : 0);
+        } break;
+        case PatternSource::Type::Texture: {
+            hasher.write_u64((uint64_t)(uintptr_t)source.texture.lock().get());
+        } break;
+    }
+
+    hasher.write_u64((uint64_t)source.size.x << 32 | (uint32_t)source.size.y);
+    hash_transform(hasher, pattern.transform);
+    hasher.write_u64(pattern.flags.value);
+
+    if (pattern.filter) {
+        auto &filter = *pattern.filter;
+        hasher.write_u64((uint64_t)filter.type + 1);
+
+        if (filter.type == PatternFilter::Type::Blur) {
+            hasher.write_u64((uint64_t)filter.blur.direction);
+            hasher.write_f32(filter.blur.sigma);
+        } else {
+            for (auto color : {filter.text.fg_color, filter.text.bg_color}) {
+                hasher.write_f32(color.r_);
+                hasher.write_f32(color.g_);
+                hasher.write_f32(color.b_);
+                hasher.write_f32(color.a_);
+            }
+        }
+    } else {
+        hasher.write_u64(0);
+    }
+}
+
+} // namespace
+
+void Palette::hash(Hasher &hasher) const {
+    for (auto &paint : paints) {
+        hasher.write_u64(paint.get_base_color().to_u32());
+
+        auto overlay = paint.get_overlay();
+        if (overlay == nullptr) {
+            hasher.write_u64(0);
+            continue;
+        }
+
+        hasher.write_u64((uint64_t)overlay->composite_op + 1);
+        hasher.write_u64((uint64_t)overlay->contents.type);
+
+        if (overlay->contents.type == PaintContents::Type::Gradient) {
+            hash_gradient(hasher, overlay->contents.gradient);
+        } else {
+            hash_pattern(hasher, overlay->contents.pattern);
+        }
+    }
+
+    for (auto &render_target : render_targets_desc) {
+        hasher.write_u64((uint64_t)render_target.size.x << 32 | (uint32_t)render_target.size.y);
+        hasher.write_u64(render_target.is_raw_texture);
+    }
+}
+
 } // namespace Pathfinder
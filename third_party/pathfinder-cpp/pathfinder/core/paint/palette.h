@@ -53,10 +53,23 @@ public:
     explicit Palette(uint32_t _scene_id);
 
     /// Push a new paint if not already in cache, and return its ID.
+    /// Solid colors are interned by value, and overlay paints by overlay identity.
     uint32_t push_paint(const Paint &paint);
 
+    /// Fast path of push_paint() for solid colors, which doesn't need to build a paint for cache hits.
+    uint32_t push_color(const ColorU &color);
+
     Paint get_paint(uint32_t paint_id) const;
 
+    uint32_t get_paint_count() const;
+
+    /// If there are no gradients, patterns or render targets, so that appending this palette doesn't depend
+    /// on the transform.
+    bool is_solid_colors_only() const;
+
+    /// Remove all paints and render targets, keeping the allocated tables.
+    void clear();
+
     RenderTargetId push_render_target(const RenderTargetDesc &render_target_desc);
 
     RenderTargetDesc get_render_target(RenderTargetId render_target_id) const;
@@ -67,14 +80,37 @@ public:
     /// Append another palette to this append_palette, merging paints and render targets.
     MergedPaletteInfo append_palette(const Palette &palette, const Transform2 &transform);
 
+    /// Hash all paints and render targets. Images are hashed by content, and raw textures by identity.
+    void hash(Hasher &hasher) const;
+
 private:
     std::vector<Paint> paints;
 
     /// This is not real GPU render target.
     std::vector<RenderTargetDesc> render_targets_desc;
 
-    /// Cached paints.
-    std::map<Paint, uint32_t> cache;
+    /// Interned solid color paints, keyed by packed color.
+    std::unordered_map<uint32_t, uint32_t> color_paints;
+
+    struct OverlayPaintKey {
+        /// Kept alive by the paint stored in `paints`.
+        const PaintOverlay *overlay;
+        uint32_t base_color;
+
+        bool operator==(const OverlayPaintKey &rhs) const {
+            return overlay == rhs.overlay && base_color == rhs.base_color;
+        }
+    };
+
+    struct OverlayPaintKeyHash {
+        size_t operator()(const OverlayPaintKey &key) const {
+            return std::hash<const void *>()(key.overlay) ^ ((size_t)key.base_color * 0x9e3779b97f4a7c15);
+        }
+    };
+
+    /// Interned overlay paints. Comparing gradients and patterns by content is costly, and paints that
+    /// share an overlay are usually copies of each other, so identity is used instead.
+    std::unordered_map<OverlayPaintKey, uint32_t, OverlayPaintKeyHash> overlay_paints;
 
     /// Which scene this palette belongs to.
     uint32_t scene_id;
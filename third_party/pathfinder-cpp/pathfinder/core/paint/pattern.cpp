@@ -2,6 +2,39 @@
 
 namespace Pathfinder {
 
+Image::Image(Vec2I _size, const std::vector<ColorU> &_pixels) : size(_size), owned_pixels(_pixels) {
+    pixels = owned_pixels.data();
+}
+
+Image::Image(Vec2I _size, std::vector<ColorU> &&_pixels) : size(_size), owned_pixels(std::move(_pixels)) {
+    pixels = owned_pixels.data();
+}
+
+Image::Image(Vec2I _size, const ColorU *_pixels, std::shared_ptr<const void> _owner)
+    : size(_size), pixels(_pixels), owner(std::move(_owner)) {}
+
+const ColorU *Image::get_pixels() const {
+    return pixels;
+}
+
+uint64_t Image::get_hash() const {
+    auto hash = pixels_hash.load(std::memory_order_relaxed);
+
+    if (hash == 0) {
+        // Racing threads compute the same value.
+        hash = fnv_hash(reinterpret_cast<const char *>(pixels), (size_t)size.area() * sizeof(ColorU));
+        // Reserve zero for "not computed".
+        hash = hash == 0 ? 1 : hash;
+        pixels_hash.store(hash, std::memory_order_relaxed);
+    }
+
+    return hash;
+}
+
+void Image::set_content_key(uint64_t key) {
+    pixels_hash.store(key == 0 ? 1 : key, std::memory_order_relaxed);
+}
+
 bool Pattern::repeat_x() const {
     return (flags.value & PatternFlags::REPEAT_X) != 0x0;
 }
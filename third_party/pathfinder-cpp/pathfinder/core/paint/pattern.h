@@ -3,7 +3,9 @@
 
 //! Raster image patterns.
 
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -34,28 +36,50 @@ struct RenderTargetId {
 class Image {
 public:
     Vec2I size;
-    std::vector<ColorU> pixels;
-    uint64_t pixels_hash;
 
-    Image(Vec2I _size, const std::vector<ColorU> &_pixels) {
-        size = _size;
-        pixels = _pixels;
-        pixels_hash = fnv_hash(reinterpret_cast<const char *>(pixels.data()), pixels.size() * 4);
-    }
+    /// Copies the pixels.
+    Image(Vec2I _size, const std::vector<ColorU> &_pixels);
+
+    /// Takes the pixels without copying.
+    Image(Vec2I _size, std::vector<ColorU> &&_pixels);
+
+    /// Uses pixels stored elsewhere (e.g. a decoder buffer or a mapped file) without copying.
+    /// The storage is kept alive by `_owner`.
+    Image(Vec2I _size, const ColorU *_pixels, std::shared_ptr<const void> _owner);
+
+    Image(const Image &) = delete;
+
+    Image &operator=(const Image &) = delete;
+
+    /// `size.area()` pixels, row by row.
+    const ColorU *get_pixels() const;
 
     /// Returns a non-cryptographic hash of the image, which should be globally unique.
-    uint64_t get_hash() const {
-        return pixels_hash;
-    }
+    /// The pixels are hashed on first use, unless a content key was provided.
+    uint64_t get_hash() const;
+
+    /// Use a key which identifies the content (e.g. derived from a file path and modification time)
+    /// instead of hashing the pixels. Must be non-zero.
+    void set_content_key(uint64_t key);
 
     // For being used as key in ordered maps.
     bool operator<(const Image &rhs) const {
         bool res = size.x < rhs.size.x;
         res = res && size.y < rhs.size.y;
-        res = res && pixels_hash < rhs.pixels_hash;
+        res = res && get_hash() < rhs.get_hash();
 
         return res;
     }
+
+private:
+    std::vector<ColorU> owned_pixels;
+
+    const ColorU *pixels{};
+
+    std::shared_ptr<const void> owner;
+
+    /// Zero until computed.
+    mutable std::atomic<uint64_t> pixels_hash{0};
 };
 
 /// A raster image target that can be rendered to and later reused as a pattern.
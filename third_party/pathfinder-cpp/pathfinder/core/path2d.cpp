@@ -4,6 +4,19 @@
 
 namespace Pathfinder {
 
+Path2d::Path2d(Arena *_arena) : arena(_arena), current_contour(_arena), outline(_arena) {}
+
+Path2d::Path2d(const Path2d &other, Arena *_arena)
+    : arena(_arena), current_contour(other.current_contour, _arena), outline(other.outline, _arena) {}
+
+Path2d::Path2d(const Path2d &other) : Path2d(other, nullptr) {}
+
+Path2d &Path2d::operator=(const Path2d &other) {
+    current_contour = other.current_contour;
+    outline = other.outline;
+    return *this;
+}
+
 void Path2d::close_path() {
     current_contour.close();
 }
@@ -159,15 +172,25 @@ void Path2d::add_circle(const Vec2F &center, float radius) {
     close_path();
 }
 
-Outline Path2d::into_outline() {
+Outline Path2d::into_outline() & {
     flush_current_contour();
     return outline;
 }
 
+Outline Path2d::into_outline(Arena *target_arena) & {
+    flush_current_contour();
+    return {outline, target_arena};
+}
+
+Outline Path2d::into_outline() && {
+    flush_current_contour();
+    return std::move(outline);
+}
+
 void Path2d::flush_current_contour() {
     if (!current_contour.is_empty()) {
-        outline.push_contour(current_contour);
-        current_contour = Contour();
+        outline.push_contour(std::move(current_contour));
+        current_contour = Contour(arena);
     }
 }
 
@@ -9,6 +9,25 @@ namespace Pathfinder {
 
 class Path2d {
 public:
+    Path2d() = default;
+
+    /// A path built in an arena, such as a scene's (see Canvas::create_path()).
+    /// The arena must not be reset before the path is consumed.
+    explicit Path2d(Arena *_arena);
+
+    /// Copy a path into an arena.
+    Path2d(const Path2d &other, Arena *_arena);
+
+    /// Like arena vectors, a copy never shares the arena, as it may outlive it.
+    Path2d(const Path2d &other);
+
+    Path2d(Path2d &&other) = default;
+
+    /// Keeps the arena of this path.
+    Path2d &operator=(const Path2d &other);
+
+    Path2d &operator=(Path2d &&other) = default;
+
     // Basic geometries.
     // -----------------------------------------------
     void close_path();
@@ -33,10 +52,19 @@ public:
     void add_circle(const Vec2F &center, float radius);
     // -----------------------------------------------
 
-    /// Returns the outline.
-    Outline into_outline();
+    /// Returns a copy of the outline.
+    Outline into_outline() &;
+
+    /// Returns a copy of the outline, placed in an arena.
+    Outline into_outline(Arena *target_arena) &;
+
+    /// Returns the outline, moving it out of a path that's no longer needed.
+    Outline into_outline() &&;
 
 private:
+    /// Where the contours are allocated. Null for the heap.
+    Arena *arena{};
+
     Contour current_contour;
 
     Outline outline;
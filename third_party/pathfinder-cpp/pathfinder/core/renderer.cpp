@@ -13,6 +13,8 @@ Renderer::Renderer(const std::shared_ptr<Device> &_device, const std::shared_ptr
     : device(_device), queue(_queue) {
     allocator = std::make_shared<GpuMemoryAllocator>(device);
 
+    paint_texture_manager = std::make_shared<PaintTextureManager>();
+
     // Area-Lut texture.
     auto image_buffer = ImageBuffer::from_memory({std::begin(area_lut_png), std::end(area_lut_png)}, false);
 
@@ -69,6 +71,10 @@ void Renderer::declare_render_target(RenderTargetId render_target_id, TextureLoc
     render_target = location;
 }
 
+std::shared_ptr<PaintTextureManager> Renderer::get_paint_texture_manager() const {
+    return paint_texture_manager;
+}
+
 TextureLocation Renderer::get_render_target_location(RenderTargetId render_target_id) {
     return render_target_locations[render_target_id.render_target];
 }
@@ -85,7 +91,7 @@ RenderTarget Renderer::get_render_target(RenderTargetId render_target_id) {
     return {allocator->get_texture(texture_page->texture_id_)};
 }
 
-void Renderer::upload_texel_data(std::vector<ColorU> &texels, TextureLocation location) {
+void Renderer::upload_texel_data(const ColorU *texels, TextureLocation location) {
     if (location.page >= pattern_texture_pages.size()) {
         Logger::error("Texture page ID is invalid!");
         return;
@@ -100,7 +106,7 @@ void Renderer::upload_texel_data(std::vector<ColorU> &texels, TextureLocation lo
     auto texture = allocator->get_texture(texture_page->texture_id_);
 
     auto encoder = device->create_command_encoder("upload data of the pattern texture pages");
-    encoder->write_texture(texture, location.rect, texels.data());
+    encoder->write_texture(texture, location.rect, texels);
     queue->submit_and_wait(encoder);
 
     texture_page->must_preserve_contents_ = true;
@@ -24,6 +24,8 @@ struct RenderTarget {
     std::shared_ptr<Texture> texture;
 };
 
+struct PaintTextureManager;
+
 void upload_texture_metadata(const std::shared_ptr<Texture> &metadata_texture,
                              const std::vector<TextureMetadataEntry> &metadata,
                              const std::shared_ptr<Device> &device);
@@ -65,10 +67,14 @@ public:
     /// Allocate GPU resources for a pattern texture page.
     void allocate_pattern_texture_page(uint64_t page_id, Vec2I texture_size);
 
-    void upload_texel_data(std::vector<ColorU> &texels, TextureLocation location);
+    void upload_texel_data(const ColorU *texels, TextureLocation location);
 
     void declare_render_target(RenderTargetId render_target_id, TextureLocation location);
 
+    /// Allocations of the pattern texture pages, kept across scene builds,
+    /// so that the texels of cached images are only uploaded once.
+    std::shared_ptr<PaintTextureManager> get_paint_texture_manager() const;
+
     virtual void set_up_pipelines() = 0;
 
     virtual std::shared_ptr<Texture> get_dest_texture() = 0;
@@ -126,6 +132,7 @@ protected:
     // -----------------------------------------------
     std::vector<TextureLocation> render_target_locations;
     std::vector<std::shared_ptr<PatternTexturePage>> pattern_texture_pages;
+    std::shared_ptr<PaintTextureManager> paint_texture_manager;
     // -----------------------------------------------
 
     std::vector<std::shared_ptr<Sampler>> samplers;
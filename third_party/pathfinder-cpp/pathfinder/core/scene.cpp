@@ -33,6 +33,12 @@ uint32_t Scene::push_paint(const Paint &paint) {
     return paint_id;
 }
 
+uint32_t Scene::push_color_paint(const ColorU &color) {
+    auto paint_id = palette.push_color(color);
+    epoch.next();
+    return paint_id;
+}
+
 Paint Scene::get_paint(uint32_t paint_id) const {
     return palette.get_paint(paint_id);
 }
@@ -40,7 +46,22 @@ Paint Scene::get_paint(uint32_t paint_id) const {
 uint32_t Scene::push_draw_path(const DrawPath &draw_path) {
     auto draw_path_index = draw_paths.size();
 
-    draw_paths.push_back(draw_path);
+    draw_paths.emplace_back(draw_path, &arena);
+
+    push_draw_path_with_index(draw_path_index);
+
+    return draw_path_index;
+}
+
+uint32_t Scene::push_draw_path(DrawPath &&draw_path) {
+    // Outlines built elsewhere are copied into the arena.
+    if (!draw_path.outline.is_in_arena(&arena)) {
+        return push_draw_path(static_cast<const DrawPath &>(draw_path));
+    }
+
+    auto draw_path_index = draw_paths.size();
+
+    draw_paths.push_back(std::move(draw_path));
 
     push_draw_path_with_index(draw_path_index);
 
@@ -50,7 +71,19 @@ uint32_t Scene::push_draw_path(const DrawPath &draw_path) {
 uint32_t Scene::push_clip_path(const ClipPath &clip_path) {
     bounds = bounds.union_rect(clip_path.outline.bounds);
     uint32_t clip_path_id = clip_paths.size();
-    clip_paths.push_back(clip_path);
+    clip_paths.emplace_back(clip_path, &arena);
+    epoch.next();
+    return clip_path_id;
+}
+
+uint32_t Scene::push_clip_path(ClipPath &&clip_path) {
+    if (!clip_path.outline.is_in_arena(&arena)) {
+        return push_clip_path(static_cast<const ClipPath &>(clip_path));
+    }
+
+    bounds = bounds.union_rect(clip_path.outline.bounds);
+    uint32_t clip_path_id = clip_paths.size();
+    clip_paths.push_back(std::move(clip_path));
     epoch.next();
     return clip_path_id;
 }
@@ -62,8 +95,9 @@ void Scene::push_draw_path_with_index(uint32_t draw_path_id) {
 
     auto end_path_id = draw_path_id + 1;
 
-    // Get the last DrawPaths display item.
-    if (!display_list.empty() && display_list.back().type == DisplayItem::Type::DrawPaths) {
+    // Get the last DrawPaths display item, if this path follows it.
+    if (!display_list.empty() && display_list.back().type == DisplayItem::Type::DrawPaths &&
+        display_list.back().range.end == draw_path_id) {
         auto &range = display_list.back().range;
 
         range.end = end_path_id;
@@ -79,11 +113,71 @@ void Scene::push_draw_path_with_index(uint32_t draw_path_id) {
 }
 
 void Scene::append_scene(const Scene &scene, const Transform2 &transform) {
-    if (scene.draw_paths.empty()) {
+    merge_scene(scene, transform, nullptr);
+
+    // Bump epoch.
+    epoch.next();
+}
+
+void Scene::push_scene_instance(const std::shared_ptr<const Scene> &scene, const Transform2 &transform) {
+    if (scene == nullptr || scene->is_empty()) {
+        return;
+    }
+
+    DisplayItem display_item;
+    display_item.type = DisplayItem::Type::DrawScene;
+    display_item.instance = instances.size();
+
+    instances.push_back({scene, transform});
+    display_list.push_back(display_item);
+
+    bounds = bounds.union_rect(transform * scene->get_bounds());
+
+    epoch.next();
+}
+
+void Scene::expand_instances() {
+    if (instances.empty()) {
         return;
     }
 
-    auto merged_palette_info = palette.append_palette(scene.palette, transform);
+    auto old_display_list = std::move(display_list);
+    display_list.clear();
+
+    PaletteMappingCache palette_mapping_cache;
+
+    for (auto &display_item : old_display_list) {
+        if (display_item.type == DisplayItem::Type::DrawScene) {
+            auto &instance = instances[display_item.instance];
+            merge_scene(*instance.scene, instance.transform, &palette_mapping_cache);
+        } else {
+            display_list.push_back(display_item);
+        }
+    }
+
+    instances.clear();
+
+    epoch.next();
+}
+
+void Scene::merge_scene(const Scene &scene,
+                        const Transform2 &transform,
+                        PaletteMappingCache *palette_mapping_cache) {
+    if (scene.is_empty()) {
+        return;
+    }
+
+    // Solid colors don't depend on the transform, so a scene drawn many times needs merging only once.
+    MergedPaletteInfo merged_palette_info;
+    if (palette_mapping_cache && scene.palette.is_solid_colors_only()) {
+        auto iter = palette_mapping_cache->find(&scene);
+        if (iter == palette_mapping_cache->end()) {
+            iter = palette_mapping_cache->insert({&scene, palette.append_palette(scene.palette, transform)}).first;
+        }
+        merged_palette_info = iter->second;
+    } else {
+        merged_palette_info = palette.append_palette(scene.palette, transform);
+    }
 
     // Merge clip paths.
     std::vector<size_t> clip_path_mapping;
@@ -91,10 +185,8 @@ void Scene::append_scene(const Scene &scene, const Transform2 &transform) {
     for (auto &clip_path : scene.clip_paths) {
         clip_path_mapping.push_back(clip_paths.size());
 
-        auto new_clip_path = clip_path;
+        auto &new_clip_path = clip_paths.emplace_back(clip_path, &arena);
         new_clip_path.outline.transform(transform);
-
-        clip_paths.push_back(new_clip_path);
     }
 
     // Merge draw paths.
@@ -103,15 +195,13 @@ void Scene::append_scene(const Scene &scene, const Transform2 &transform) {
     for (auto &draw_path : scene.draw_paths) {
         draw_path_mapping.push_back(draw_paths.size());
 
-        auto new_draw_path = draw_path;
+        auto &new_draw_path = draw_paths.emplace_back(draw_path, &arena);
         new_draw_path.paint = merged_palette_info.paint_mapping[draw_path.paint];
         if (draw_path.clip_path) {
             new_draw_path.clip_path = std::make_shared<uint32_t>(clip_path_mapping[*draw_path.clip_path]);
         }
 
         new_draw_path.outline.transform(transform);
-
-        draw_paths.push_back(new_draw_path);
     }
 
     // Merge display items.
@@ -138,11 +228,12 @@ void Scene::append_scene(const Scene &scene, const Transform2 &transform) {
                     push_draw_path_with_index(new_draw_path_id);
                 }
             } break;
+            case DisplayItem::Type::DrawScene: {
+                auto &instance = scene.instances[display_item.instance];
+                merge_scene(*instance.scene, transform * instance.transform, palette_mapping_cache);
+            } break;
         }
     }
-
-    // Bump epoch.
-    epoch.next();
 }
 
 RenderTargetId Scene::push_render_target(const RenderTargetDesc &render_target_desc) {
@@ -162,6 +253,7 @@ void Scene::pop_render_target() {
     DisplayItem item{};
     item.type = DisplayItem::Type::PopRenderTarget;
     display_list.push_back(item);
+    epoch.next();
 }
 
 RectF Scene::get_view_box() const {
@@ -188,4 +280,94 @@ void Scene::set_bounds(const RectF &new_bounds) {
     epoch.next();
 }
 
+void Scene::clear() {
+    display_list.clear();
+    draw_paths.clear();
+    clip_paths.clear();
+    instances.clear();
+    // All outlines are gone, so their memory can be reused.
+    arena.reset();
+    palette.clear();
+    bounds = RectF();
+    epoch.next();
+}
+
+bool Scene::is_empty() const {
+    return draw_paths.empty() && instances.empty();
+}
+
+namespace {
+
+const float HASH_COORDINATE_SCALE = 64.f;
+
+void hash_point(Hasher &hasher, const Vec2F &point) {
+    auto x = (uint32_t)(int32_t)std::round(point.x * HASH_COORDINATE_SCALE);
+    auto y = (uint32_t)(int32_t)std::round(point.y * HASH_COORDINATE_SCALE);
+    hasher.write_u64((uint64_t)x << 32 | y);
+}
+
+void hash_outline(Hasher &hasher, const Outline &outline) {
+    hasher.write_u64(outline.contours.size());
+
+    for (auto &contour : outline.contours) {
+        hasher.write_u64(contour.points.size() << 1 | (uint64_t)contour.closed);
+
+        for (size_t i = 0; i < contour.points.size(); i++) {
+            hash_point(hasher, contour.points[i]);
+            hasher.write_u64((uint64_t)contour.flags[i]);
+        }
+    }
+}
+
+} // namespace
+
+uint64_t Scene::compute_hash() const {
+    // Scenes drawn as instances are hashed once as long as they don't change.
+    if (cached_hash && cached_hash->first == epoch) {
+        return cached_hash->second;
+    }
+
+    Hasher hasher;
+
+    hash_point(hasher, view_box.origin());
+    hash_point(hasher, view_box.lower_right());
+
+    for (auto &display_item : display_list) {
+        hasher.write_u64((uint64_t)display_item.type);
+        hasher.write_u64(display_item.render_target_id.render_target);
+        hasher.write_u64(display_item.range.start);
+        hasher.write_u64(display_item.range.end);
+
+        if (display_item.type == DisplayItem::Type::DrawScene) {
+            auto &instance = instances[display_item.instance];
+            hasher.write_u64(instance.scene->compute_hash());
+            auto &transform = instance.transform;
+            for (auto value : {transform.m11(), transform.m21(), transform.m12(), transform.m22()}) {
+                hasher.write_f32(value);
+            }
+            hash_point(hasher, transform.get_position());
+        }
+    }
+
+    for (auto &draw_path : draw_paths) {
+        hash_outline(hasher, draw_path.outline);
+        hasher.write_u64(draw_path.paint);
+        hasher.write_u64(draw_path.clip_path ? *draw_path.clip_path + 1ull : 0);
+        hasher.write_u64((uint64_t)draw_path.fill_rule);
+        hasher.write_u64((uint64_t)draw_path.blend_mode);
+    }
+
+    for (auto &clip_path : clip_paths) {
+        hash_outline(hasher, clip_path.outline);
+        hasher.write_u64(clip_path.clip_path ? *clip_path.clip_path + 1ull : 0);
+        hasher.write_u64((uint64_t)clip_path.fill_rule);
+    }
+
+    palette.hash(hasher);
+
+    cached_hash = {epoch, hasher.finish()};
+
+    return cached_hash->second;
+}
+
 } // namespace Pathfinder
@@ -3,6 +3,7 @@
 
 #include <limits>
 #include <map>
+#include <optional>
 #include <vector>
 
 #include "../common/math/basic.h"
@@ -25,11 +26,16 @@ struct DisplayItem {
 
         /// Pops a render target from the stack.
         PopRenderTarget,
+
+        /// Draws an instance of another scene. Replaced by draw paths in `Scene::expand_instances()`.
+        DrawScene,
     } type = Type::DrawPaths;
 
     RenderTargetId render_target_id{}; // For PushRenderTarget.
 
     Range range; // For DrawPaths.
+
+    uint32_t instance = 0; // For DrawScene.
 };
 
 /// Used to control RenderTarget changing.
@@ -43,6 +49,10 @@ struct SceneEpoch {
     SceneEpoch successor() const;
 
     void next();
+
+    bool operator==(const SceneEpoch &rhs) const {
+        return hi == rhs.hi && lo == rhs.lo;
+    }
 };
 
 struct LastSceneInfo {
@@ -56,8 +66,19 @@ struct LastSceneInfo {
 /// You can see scenes as an analogy of SVG images.
 class Scene {
 public:
+    /// A reference to another scene, to be drawn with a transform.
+    struct Instance {
+        std::shared_ptr<const Scene> scene;
+        Transform2 transform;
+    };
+
     explicit Scene(uint32_t _id, RectF _view_box);
 
+    /// Holds the outlines of draw paths and clip paths until the scene is cleared, so that building
+    /// a frame doesn't allocate and free each contour on the heap.
+    /// Declared before the paths to outlive them.
+    Arena arena;
+
     std::vector<DisplayItem> display_list;
 
     std::vector<DrawPath> draw_paths;
@@ -67,6 +88,9 @@ public:
     /// Contains paints.
     Palette palette;
 
+    /// Referenced by DrawScene display items.
+    std::vector<Instance> instances;
+
     /// A globally-unique identifier for the scene.
     uint32_t id;
 
@@ -81,9 +105,16 @@ public:
      */
     uint32_t push_draw_path(const DrawPath &draw_path);
 
+    /// Adds a shape without copying its outline if the outline is already in the arena
+    /// (e.g. built from Canvas::create_path()). Otherwise, the outline is copied into the arena.
+    uint32_t push_draw_path(DrawPath &&draw_path);
+
     /// Defines a clip path. Returns an ID that can be used to later clip draw paths.
     uint32_t push_clip_path(const ClipPath &clip_path);
 
+    /// Like push_draw_path(DrawPath &&), the outline is only copied if it's not in the arena.
+    uint32_t push_clip_path(ClipPath &&clip_path);
+
     void push_draw_path_with_index(uint32_t draw_path_id);
 
     /// Directs subsequent draw paths to draw to the given render target instead of the output.
@@ -107,12 +138,27 @@ public:
      */
     void append_scene(const Scene &scene, const Transform2 &transform);
 
+    /**
+     * Draw another scene by reference, which is much cheaper than append_scene() for scenes drawn many times,
+     * like icons. The scene is only copied in expand_instances() before building, and is not copied at all if
+     * this scene is never built. It must not be changed until then.
+     * @param scene Scene to draw.
+     * @param transform Additional transform for the instanced scene.
+     */
+    void push_scene_instance(const std::shared_ptr<const Scene> &scene, const Transform2 &transform);
+
+    /// Replace scene instances with copies of their paths. This is done by the canvas before building.
+    void expand_instances();
+
     /**
      * Defines a new paint, which specifies how paths are to be filled or stroked.
      * @return ID that can be later specified alongside draw paths.
      */
     uint32_t push_paint(const Paint &paint);
 
+    /// Defines a solid color paint. Faster than push_paint() for repeated colors.
+    uint32_t push_color_paint(const ColorU &color);
+
     /// Returns the paint with the given ID.
     Paint get_paint(uint32_t paint_id) const;
 
@@ -126,9 +172,27 @@ public:
 
     void set_bounds(const RectF &new_bounds);
 
+    /// Remove all contents, keeping the view box and allocated memory.
+    void clear();
+
+    /// If there's nothing to draw.
+    bool is_empty() const;
+
+    /// A fingerprint of the scene contents, to detect if a scene differs from a previously rendered one.
+    /// Coordinates are quantized to 1/64 pixel, so that floating-point noise doesn't change the hash.
+    uint64_t compute_hash() const;
+
 private:
+    /// Paint and render target mappings of instanced scenes whose merging doesn't depend on the transform.
+    using PaletteMappingCache = std::map<const Scene *, MergedPaletteInfo>;
+
+    void merge_scene(const Scene &scene, const Transform2 &transform, PaletteMappingCache *palette_mapping_cache);
+
     RectF bounds;
 
+    /// Cached result of compute_hash(), valid for the epoch it was computed at.
+    mutable std::optional<std::pair<SceneEpoch, uint64_t>> cached_hash;
+
     /// Scene-wide clipping control.
     RectF view_box;
 };
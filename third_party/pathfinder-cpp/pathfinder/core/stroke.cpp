@@ -57,11 +57,12 @@ void ContourStrokeToFill::offset_backward() {
     }
 }
 
-OutlineStrokeToFill::OutlineStrokeToFill(const Outline &_input, StrokeStyle _style) : input(_input), style(_style) {}
+OutlineStrokeToFill::OutlineStrokeToFill(const Outline &_input, StrokeStyle _style, Arena *_arena)
+    : input(_input), style(_style), arena(_arena) {}
 
 void OutlineStrokeToFill::offset() {
     // Resulting contours.
-    std::vector<Contour> new_contours;
+    ArenaVector<Contour> new_contours(arena);
 
     // Convert each contour.
     for (auto &contour : input.contours) {
@@ -100,11 +101,11 @@ void OutlineStrokeToFill::offset() {
         p.update_bounds(new_bounds);
     }
 
-    output.contours = new_contours;
+    output.contours = std::move(new_contours);
     output.bounds = new_bounds;
 }
 
-Outline OutlineStrokeToFill::into_outline() const {
+Outline OutlineStrokeToFill::into_outline() {
     // Stroke->fill conversion isn't really robust, so here we do validations on the final output.
     bool every_point_is_valid = true;
     for (auto &contour : output.contours) {
@@ -118,10 +119,10 @@ Outline OutlineStrokeToFill::into_outline() const {
         Logger::error("Something went wrong during the stroke->fill conversion!");
     }
 
-    return output;
+    return std::move(output);
 }
 
-void OutlineStrokeToFill::push_stroked_contour(std::vector<Contour> &new_contours,
+void OutlineStrokeToFill::push_stroked_contour(ArenaVector<Contour> &new_contours,
                                                ContourStrokeToFill stroker,
                                                bool closed) const {
     // Add join if necessary.
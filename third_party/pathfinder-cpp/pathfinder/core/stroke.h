@@ -49,16 +49,19 @@ struct OutlineStrokeToFill {
     const Outline &input;
     Outline output{};
     StrokeStyle style;
+    Arena *arena{};
 
-    OutlineStrokeToFill(const Outline &_input, StrokeStyle _style);
+    /// The output is allocated from an arena if one is given.
+    OutlineStrokeToFill(const Outline &_input, StrokeStyle _style, Arena *_arena = nullptr);
 
     /// Performs the stroke operation.
     void offset();
 
     /// Returns the resulting stroked outline. This should be called after `offset()`.
-    Outline into_outline() const;
+    /// Moves the output out, so it can only be called once.
+    Outline into_outline();
 
-    void push_stroked_contour(std::vector<Contour> &new_contours, ContourStrokeToFill stroker, bool closed) const;
+    void push_stroked_contour(ArenaVector<Contour> &new_contours, ContourStrokeToFill stroker, bool closed) const;
 
     void add_cap(Contour &contour) const;
 };
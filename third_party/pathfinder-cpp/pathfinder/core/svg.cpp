@@ -205,6 +205,8 @@ SvgScene::SvgScene(const std::string &svg, Canvas &canvas) {
     nsvgDelete(image);
 }
 
+SvgScene::SvgScene(std::shared_ptr<Scene> scene, Vec2F size) : scene_(std::move(scene)), size_(size) {}
+
 std::shared_ptr<Scene> SvgScene::get_scene() const {
     return scene_;
 }
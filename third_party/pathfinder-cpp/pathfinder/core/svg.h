@@ -16,6 +16,9 @@ public:
      */
     SvgScene(const std::string& svg, Canvas& canvas);
 
+    /// Wrap an already built scene, e.g. one loaded from a cache.
+    SvgScene(std::shared_ptr<Scene> scene, Vec2F size);
+
     std::shared_ptr<Scene> get_scene() const;
 
     Vec2F get_size() const;